@@ -0,0 +1,167 @@
+/** \file allocators.cpp
+ * \author Andrej Leban
+ * \date 10/2026
+ */
+
+#include "allocators.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cm
+{
+
+namespace
+{
+
+constexpr size_t hugePageSize = 2 << 20;
+
+size_t alignUp(size_t p_value, size_t p_align)
+{
+    return (p_value + p_align - 1) & ~(p_align - 1);
+}
+
+} // namespace
+
+
+// monotonicArena
+
+monotonicArena::monotonicArena(size_t p_blockSize) : m_blockSize(p_blockSize) {}
+
+monotonicArena::~monotonicArena()
+{
+    for (auto & block : m_blocks)
+    {
+        ::operator delete(block.data);
+    }
+}
+
+void * monotonicArena::allocate(size_t p_bytes, size_t p_align)
+{
+    // look for room in the current block & the ones kept from before the last reset
+    for (; m_current < m_blocks.size(); ++m_current, m_offset = 0)
+    {
+        auto & block = m_blocks[m_current];
+        auto address = reinterpret_cast<std::uintptr_t>(block.data + m_offset);
+        size_t padding = alignUp(address, p_align) - address;
+
+        if (m_offset + padding + p_bytes <= block.size)
+        {
+            void * ret = block.data + m_offset + padding;
+            m_offset += padding + p_bytes;
+            m_used += p_bytes;
+            return ret;
+        }
+    }
+
+    // operator new aligns to max_align_t, over-allocate for larger alignments
+    size_t size = std::max(m_blockSize, p_bytes + p_align);
+    m_blocks.push_back({static_cast<std::byte *>(::operator new(size)), size});
+    m_current = m_blocks.size() - 1;
+    m_offset = 0;
+
+    return allocate(p_bytes, p_align);
+}
+
+void monotonicArena::reset() noexcept
+{
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+size_t monotonicArena::used() const noexcept
+{
+    return m_used;
+}
+
+size_t monotonicArena::capacity() const noexcept
+{
+    size_t ret = 0;
+    for (const auto & block : m_blocks)
+    {
+        ret += block.size;
+    }
+    return ret;
+}
+
+
+// huge pages
+
+void * hugePageAllocate(size_t p_bytes, unsigned p_flags)
+{
+    size_t bytes = alignUp(std::max<size_t>(p_bytes, 1), hugePageSize);
+
+#ifdef __linux__
+    // mmap only aligns to the base pages: over-map by a huge page, then trim the head & the tail to a 2 MiB boundary,
+    // so that the whole range can be backed by huge pages
+    void * mapped = mmap(nullptr, bytes + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+    auto address = reinterpret_cast<std::uintptr_t>(mapped);
+    size_t head = alignUp(address, hugePageSize) - address;
+    if (head != 0)
+    {
+        munmap(mapped, head);
+    }
+    if (head != hugePageSize)
+    {
+        munmap(static_cast<char *>(mapped) + head + bytes, hugePageSize - head);
+    }
+    void * ret = static_cast<char *>(mapped) + head;
+
+    // advisory only, so failures are of no consequence
+    madvise(ret, bytes, MADV_HUGEPAGE);
+    if (p_flags & hugePageNumaLocal)
+    {
+        syscall(SYS_mbind, ret, bytes, MPOL_LOCAL, nullptr, 0, 0);
+    }
+    if (p_flags & hugePagePopulate)
+    {
+        // after the advice & the policy, so the pages get faulted in as huge & on the right node
+        auto * data = static_cast<volatile char *>(ret);
+        auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (size_t page = 0; page < bytes; page += pageSize)
+        {
+            data[page] = 0;
+        }
+    }
+    return ret;
+#else
+    (void)p_flags;
+    void * ret = std::aligned_alloc(hugePageSize, bytes);
+    if (!ret)
+    {
+        throw std::bad_alloc();
+    }
+    return ret;
+#endif
+}
+
+void hugePageDeallocate(void * p_ptr, size_t p_bytes) noexcept
+{
+    if (!p_ptr)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    munmap(p_ptr, alignUp(std::max<size_t>(p_bytes, 1), hugePageSize));
+#else
+    (void)p_bytes;
+    std::free(p_ptr);
+#endif
+}
+
+} // namespace cm
@@ -0,0 +1,300 @@
+/** \file allocators.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Allocators for the large containers, e.g. the trees.
+ */
+
+#ifndef CM_ALLOCATORS_H
+#define CM_ALLOCATORS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace cm
+{
+
+//! @name Memory resources
+///@{
+
+//! \brief A monotonic arena: allocations bump a pointer within large blocks & are only ever released all at once.
+//! reset() keeps the blocks for reuse, so a steady-state workload, e.g. pricing tree after tree, never reaches malloc.
+//! Not thread-safe; use an arena per thread.
+class monotonicArena
+{
+public:
+    //! \brief monotonicArena
+    //! \param p_blockSize - The size of the blocks requested from the system; larger requests get a block of their own.
+    explicit monotonicArena(size_t p_blockSize = 1 << 20);
+    monotonicArena(const monotonicArena &) = delete;
+    monotonicArena & operator=(const monotonicArena &) = delete;
+    ~monotonicArena();
+
+    //! \brief Allocates \p p_bytes aligned to \p p_align (a power of 2).
+    //! \throws std::bad_alloc
+    void * allocate(size_t p_bytes, size_t p_align = alignof(std::max_align_t));
+    //! \brief Releases all the allocations at once, keeping the blocks for reuse.
+    //! The objects in the arena are not destroyed!
+    void reset() noexcept;
+
+    //! \brief The number of bytes handed out since the last reset.
+    size_t used() const noexcept;
+    //! \brief The number of bytes held by the blocks.
+    size_t capacity() const noexcept;
+
+private:
+    struct block
+    {
+        std::byte * data;
+        size_t size;
+    };
+
+    std::vector<block> m_blocks{};
+    size_t m_blockSize;
+    // the current block & the position within it
+    size_t m_current{0};
+    size_t m_offset{0};
+    size_t m_used{0};
+};
+
+//! \brief Flags for the hugePageAllocator.
+enum hugePageFlags : unsigned
+{
+    //! \brief Only ask for transparent huge pages.
+    hugePageDefault = 0,
+    //! \brief Fault in all the pages at allocation, so that the first touch does not pay for it.
+    hugePagePopulate = 1 << 0,
+    //! \brief Bind the pages to the NUMA node of the allocating thread.
+    hugePageNumaLocal = 1 << 1
+};
+
+//! \brief Maps a region of memory backed by (transparent) huge pages where available.
+//! The region is aligned to the huge page size. Falls back on the system allocator on platforms without mmap.
+//! \param p_bytes - rounded up to a multiple of the huge page size
+//! \param p_flags - a combination of the hugePageFlags
+//! \throws std::bad_alloc
+void * hugePageAllocate(size_t p_bytes, unsigned p_flags = hugePageDefault);
+//! \brief Frees a region allocated via hugePageAllocate with the same \p p_bytes.
+void hugePageDeallocate(void * p_ptr, size_t p_bytes) noexcept;
+///@}
+
+
+//! @name Allocators
+///@{
+
+//! \brief A std-conforming allocator that serves from a monotonicArena.
+//! Deallocation is a no-op, the memory is reclaimed when the arena is reset or destroyed.
+template <typename T>
+class arenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit arenaAllocator(monotonicArena & p_arena) noexcept;
+    template <typename U>
+    arenaAllocator(const arenaAllocator<U> & p_other) noexcept;
+
+    T * allocate(size_t p_n);
+    void deallocate(T *, size_t) noexcept {}
+
+    monotonicArena * arena() const noexcept;
+
+private:
+    monotonicArena * m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const arenaAllocator<T> & p_lhs, const arenaAllocator<U> & p_rhs) noexcept;
+template <typename T, typename U>
+bool operator!=(const arenaAllocator<T> & p_lhs, const arenaAllocator<U> & p_rhs) noexcept;
+
+//! \brief A std-conforming allocator that maps each allocation separately, backed by huge pages
+//! & optionally pre-faulted & bound to the local NUMA node, \see hugePageFlags.
+//! Meant for few large allocations, e.g. the array of a multi-GB tree, where it cuts the TLB misses & page faults.
+template <typename T>
+class hugePageAllocator
+{
+public:
+    using value_type = T;
+
+    explicit hugePageAllocator(unsigned p_flags = hugePageDefault) noexcept;
+    template <typename U>
+    hugePageAllocator(const hugePageAllocator<U> & p_other) noexcept;
+
+    T * allocate(size_t p_n);
+    void deallocate(T * p_ptr, size_t p_n) noexcept;
+
+    unsigned flags() const noexcept;
+
+private:
+    unsigned m_flags;
+};
+
+template <typename T, typename U>
+bool operator==(const hugePageAllocator<T> & p_lhs, const hugePageAllocator<U> & p_rhs) noexcept;
+template <typename T, typename U>
+bool operator!=(const hugePageAllocator<T> & p_lhs, const hugePageAllocator<U> & p_rhs) noexcept;
+
+//! \brief A std-conforming allocator aligning each allocation to \p Alignment bytes, at least to that of \a T.
+//! The default of 64 is a cache line & the width of an AVX-512 register, so that the vectorized loops over the array
+//! start on a boundary & no vector load straddles two lines.
+//! \tparam Alignment: a power of 2.
+template <typename T, size_t Alignment = 64>
+class alignedAllocator
+{
+    static_assert((Alignment & (Alignment - 1)) == 0, "The alignment has to be a power of 2");
+
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = alignedAllocator<U, Alignment>;
+    };
+
+    alignedAllocator() noexcept = default;
+    template <typename U>
+    alignedAllocator(const alignedAllocator<U, Alignment> & p_other) noexcept;
+
+    T * allocate(size_t p_n);
+    void deallocate(T * p_ptr, size_t p_n) noexcept;
+
+private:
+    static constexpr std::align_val_t alignment{std::max(Alignment, alignof(T))};
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const alignedAllocator<T, Alignment> & p_lhs, const alignedAllocator<U, Alignment> & p_rhs) noexcept;
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const alignedAllocator<T, Alignment> & p_lhs, const alignedAllocator<U, Alignment> & p_rhs) noexcept;
+///@}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+// arenaAllocator
+
+template <typename T>
+arenaAllocator<T>::arenaAllocator(monotonicArena & p_arena) noexcept : m_arena(&p_arena)
+{}
+
+template <typename T>
+template <typename U>
+arenaAllocator<T>::arenaAllocator(const arenaAllocator<U> & p_other) noexcept : m_arena(p_other.arena())
+{}
+
+template <typename T>
+T * arenaAllocator<T>::allocate(size_t p_n)
+{
+    return static_cast<T *>(m_arena->allocate(p_n * sizeof(T), alignof(T)));
+}
+
+template <typename T>
+monotonicArena * arenaAllocator<T>::arena() const noexcept
+{
+    return m_arena;
+}
+
+template <typename T, typename U>
+bool operator==(const arenaAllocator<T> & p_lhs, const arenaAllocator<U> & p_rhs) noexcept
+{
+    return p_lhs.arena() == p_rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const arenaAllocator<T> & p_lhs, const arenaAllocator<U> & p_rhs) noexcept
+{
+    return !(p_lhs == p_rhs);
+}
+
+
+// hugePageAllocator
+
+template <typename T>
+hugePageAllocator<T>::hugePageAllocator(unsigned p_flags) noexcept : m_flags(p_flags)
+{}
+
+template <typename T>
+template <typename U>
+hugePageAllocator<T>::hugePageAllocator(const hugePageAllocator<U> & p_other) noexcept : m_flags(p_other.flags())
+{}
+
+template <typename T>
+T * hugePageAllocator<T>::allocate(size_t p_n)
+{
+    return static_cast<T *>(hugePageAllocate(p_n * sizeof(T), m_flags));
+}
+
+template <typename T>
+void hugePageAllocator<T>::deallocate(T * p_ptr, size_t p_n) noexcept
+{
+    hugePageDeallocate(p_ptr, p_n * sizeof(T));
+}
+
+template <typename T>
+unsigned hugePageAllocator<T>::flags() const noexcept
+{
+    return m_flags;
+}
+
+template <typename T, typename U>
+bool operator==(const hugePageAllocator<T> &, const hugePageAllocator<U> &) noexcept
+{
+    // any instance can free the memory of any other
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const hugePageAllocator<T> & p_lhs, const hugePageAllocator<U> & p_rhs) noexcept
+{
+    return !(p_lhs == p_rhs);
+}
+
+
+// alignedAllocator
+
+template <typename T, size_t Alignment>
+template <typename U>
+alignedAllocator<T, Alignment>::alignedAllocator(const alignedAllocator<U, Alignment> &) noexcept
+{}
+
+template <typename T, size_t Alignment>
+T * alignedAllocator<T, Alignment>::allocate(size_t p_n)
+{
+    if (p_n > std::numeric_limits<size_t>::max() / sizeof(T))
+    {
+        throw std::bad_array_new_length();
+    }
+    return static_cast<T *>(::operator new(p_n * sizeof(T), alignment));
+}
+
+template <typename T, size_t Alignment>
+void alignedAllocator<T, Alignment>::deallocate(T * p_ptr, size_t p_n) noexcept
+{
+    ::operator delete(p_ptr, p_n * sizeof(T), alignment);
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const alignedAllocator<T, Alignment> &, const alignedAllocator<U, Alignment> &) noexcept
+{
+    // stateless
+    return true;
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const alignedAllocator<T, Alignment> & p_lhs, const alignedAllocator<U, Alignment> & p_rhs) noexcept
+{
+    return !(p_lhs == p_rhs);
+}
+
+} // namespace cm
+
+#endif // CM_ALLOCATORS_H
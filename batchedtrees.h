@@ -0,0 +1,185 @@
+/** \file batchedtrees.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Array-based trees holding a batch of instruments of identical geometry.
+ */
+
+#ifndef CM_BATCHEDTREES_H
+#define CM_BATCHEDTREES_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <common/allocators.h>
+#include <common/trees.h>
+
+namespace cm
+{
+
+//! \brief A contiguous span of a level of a batchedTree, as handed to the induction kernels.
+//! The same as levelSpan, with the batch interleaved per node: lane k of the span's i-th node is current[i * lanes + k].
+template <typename T>
+struct batchedLevelSpan
+{
+    //! \brief The level of the \a current nodes.
+    size_t level;
+    //! \brief The position of the first node of the span within its level.
+    size_t offset;
+    //! \brief The number of nodes in the span on \a level.
+    size_t size;
+    //! \brief The number of instruments in the batch.
+    size_t lanes;
+    T * current;
+    const T * next;
+};
+
+//! \brief A fixed-depth tree holding \a lanes instruments of the same depth & geometry in a single array.
+//! The storage is node-major & lane-minor, i.e. the values of all the instruments for a node are adjacent, so that
+//! an induction kernel can process all the lanes at once with the inner loop mapping directly onto SIMD registers.
+//! The geometry is shared by the whole batch.
+//! The array starts on a boundary of the allocator's alignment; the lanes of a node are not padded, so each
+//! node's lanes start on such a boundary as well only if \a lanes * sizeof(T) is a multiple of it. For aligned vector loads
+//! throughout, choose \a lanes as a multiple of the vector width, e.g. 8 doubles for AVX-512.
+//! \tparam Geometry: one of the geometries in trees.h or a class of the same interface.
+//! \tparam Alloc: the allocator of the underlying array, by default aligned to a cache line, \see alignedAllocator.
+template <typename T, typename Geometry, typename Alloc = alignedAllocator<T>>
+class batchedTree : public Geometry
+{
+public:
+    using value_type = T;
+    using geometry = Geometry;
+    using allocator_type = Alloc;
+
+    //! \brief batchedTree
+    //! \param depth - number of sub-levels, [0, inf)
+    //! \param lanes - the number of instruments in the batch
+    //! Root is level 0!
+    batchedTree(size_t depth, size_t lanes, const Alloc & alloc = Alloc());
+
+    //! \brief The number of instruments in the batch.
+    size_t lanes() const;
+    //! \brief The number of nodes of a single instrument.
+    size_t totalElems() const;
+    //! \brief The number of total levels - the depth of the tree + 1.
+    size_t numLevels() const;
+
+    //! \brief operator []
+    //! \return The array of the \a lanes values at node \p ind.
+    T * operator[](size_t ind);
+    const T * operator[](size_t ind) const;
+
+    //! \brief The value at node \p ind of instrument \p lane.
+    T & operator()(size_t ind, size_t lane);
+    const T & operator()(size_t ind, size_t lane) const;
+
+    //! \brief The contiguous storage of \p level, starting at its left boundary.
+    //! Only available for the geometries with contiguous levels.
+    T * levelData(size_t level);
+    const T * levelData(size_t level) const;
+
+    //! \brief Sweeps the whole batch from the level above the leaves up to and including the root.
+    //! Only available for the geometries with contiguous levels.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (batchedLevelSpan<T>)
+    template <typename Kernel>
+    void backwardInduction(Kernel && kernel);
+
+private:
+    size_t m_depth;
+    size_t m_lanes;
+    std::vector<T, Alloc> m_data;
+};
+
+//! \brief A batch of recombinantBTree.
+template <typename T, typename Alloc = alignedAllocator<T>>
+using batchedRecombinantBTree = batchedTree<T, recombinantBGeometry, Alloc>;
+
+//! \brief A batch of recombinantTTree.
+template <typename T, typename Alloc = alignedAllocator<T>>
+using batchedRecombinantTTree = batchedTree<T, recombinantTGeometry, Alloc>;
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename T, typename Geometry, typename Alloc>
+batchedTree<T, Geometry, Alloc>::batchedTree(size_t depth, size_t lanes, const Alloc & alloc)
+    : m_depth(depth)
+    , m_lanes(lanes)
+    , m_data(Geometry::numElems(depth) * lanes, alloc)
+{}
+
+template <typename T, typename Geometry, typename Alloc>
+size_t batchedTree<T, Geometry, Alloc>::lanes() const
+{
+    return m_lanes;
+}
+
+template <typename T, typename Geometry, typename Alloc>
+size_t batchedTree<T, Geometry, Alloc>::totalElems() const
+{
+    return Geometry::numElems(m_depth);
+}
+
+template <typename T, typename Geometry, typename Alloc>
+size_t batchedTree<T, Geometry, Alloc>::numLevels() const
+{
+    return m_depth + 1;
+}
+
+template <typename T, typename Geometry, typename Alloc>
+T * batchedTree<T, Geometry, Alloc>::operator[](size_t ind)
+{
+    return m_data.data() + ind * m_lanes;
+}
+
+template <typename T, typename Geometry, typename Alloc>
+const T * batchedTree<T, Geometry, Alloc>::operator[](size_t ind) const
+{
+    return m_data.data() + ind * m_lanes;
+}
+
+template <typename T, typename Geometry, typename Alloc>
+T & batchedTree<T, Geometry, Alloc>::operator()(size_t ind, size_t lane)
+{
+    return m_data[ind * m_lanes + lane];
+}
+
+template <typename T, typename Geometry, typename Alloc>
+const T & batchedTree<T, Geometry, Alloc>::operator()(size_t ind, size_t lane) const
+{
+    return m_data[ind * m_lanes + lane];
+}
+
+template <typename T, typename Geometry, typename Alloc>
+T * batchedTree<T, Geometry, Alloc>::levelData(size_t level)
+{
+    return (*this)[Geometry::left_boundary(level)];
+}
+
+template <typename T, typename Geometry, typename Alloc>
+const T * batchedTree<T, Geometry, Alloc>::levelData(size_t level) const
+{
+    return (*this)[Geometry::left_boundary(level)];
+}
+
+template <typename T, typename Geometry, typename Alloc>
+template <typename Kernel>
+void batchedTree<T, Geometry, Alloc>::backwardInduction(Kernel && kernel)
+{
+    CM_PROFILE_SCOPE("batchedTree::backwardInduction");
+
+    for (size_t l = m_depth; l-- > 0;)
+    {
+        size_t size = Geometry::right_boundary(l) - Geometry::left_boundary(l) + 1;
+        kernel(batchedLevelSpan<T>{l, 0, size, m_lanes, levelData(l), std::as_const(*this).levelData(l + 1)});
+    }
+}
+
+} // namespace cm
+
+#endif // CM_BATCHEDTREES_H
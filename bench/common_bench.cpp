@@ -0,0 +1,358 @@
+/** \file common_bench.cpp
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Baseline benchmarks of the library, on Google Benchmark.
+ * Run e.g. with --benchmark_format=json --benchmark_out=<file> to compare versions.
+ */
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <common/functional.h>
+#include <common/numeric.h>
+#include <common/patterns.h>
+#include <common/stack.h>
+#include <common/stackcontainer.h>
+#include <common/thread.h>
+#include <common/trees.h>
+
+namespace
+{
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// trees
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Tree>
+void treeConstruction(benchmark::State & state)
+{
+    const auto depth = static_cast<size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        Tree tree(depth);
+        benchmark::DoNotOptimize(&tree[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(Tree(depth).totalElems()));
+}
+
+//! \brief Root to leaf along a zig-zag path, via the virtual navigation.
+template <typename Tree>
+void treeNavigation(benchmark::State & state)
+{
+    const auto depth = static_cast<size_t>(state.range(0));
+    Tree tree(depth);
+    for (size_t i = 0; i < tree.totalElems(); ++i)
+    {
+        tree[i] = static_cast<double>(i);
+    }
+
+    for (auto _ : state)
+    {
+        size_t ind = 0;
+        double sum = 0;
+        for (size_t l = 0; l < depth; ++l)
+        {
+            ind = l & 1 ? tree.goDownRight(ind) : tree.goDownLeft(ind);
+            sum += tree[ind];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(depth));
+}
+
+template <typename Tree>
+void treeNodeRefNavigation(benchmark::State & state)
+{
+    const auto depth = static_cast<size_t>(state.range(0));
+    Tree tree(depth);
+
+    for (auto _ : state)
+    {
+        cm::nodeRef<Tree> node(tree, 0);
+        for (size_t l = 0; l < depth; ++l)
+        {
+            node = l & 1 ? node.down_right() : node.down_left();
+        }
+        benchmark::DoNotOptimize(node.index());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(depth));
+}
+
+using BTree = cm::recombinantBTree<double>;
+using TTree = cm::recombinantTTree<double>;
+
+void BM_recombinantBTree_copySubTreeLeft(benchmark::State & state)
+{
+    BTree tree(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tree.copySubTreeLeft(1, 2));
+    }
+}
+
+void BM_recombinantBTree_copySubTreeRight(benchmark::State & state)
+{
+    BTree tree(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tree.copySubTreeRight(1, 2));
+    }
+}
+
+void BM_recombinantBTree_copySubTreeRanges(benchmark::State & state)
+{
+    BTree tree(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        tree.copySubTreeRanges(1, 2);
+        benchmark::DoNotOptimize(&tree[0]);
+    }
+}
+
+void BM_recombinantTTree_copySubTreeSource(benchmark::State & state)
+{
+    TTree tree(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tree.copySubTreeSource(1, 3));
+    }
+}
+
+void BM_recombinantTTree_copySubTreeTarget(benchmark::State & state)
+{
+    TTree tree(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tree.copySubTreeTarget(1, 3));
+    }
+}
+
+BENCHMARK_TEMPLATE(treeConstruction, BTree)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(treeConstruction, TTree)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(treeNavigation, BTree)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(treeNavigation, TTree)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(treeNodeRefNavigation, BTree)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK_TEMPLATE(treeNodeRefNavigation, TTree)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_recombinantBTree_copySubTreeLeft)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_recombinantBTree_copySubTreeRight)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_recombinantBTree_copySubTreeRanges)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_recombinantTTree_copySubTreeSource)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_recombinantTTree_copySubTreeTarget)->RangeMultiplier(4)->Range(16, 1024);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// barriers
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every thread of a run performs the same number of iterations, so the phases line up.
+// The barrier is shared by all the runs of the same thread count, hence a static per instantiation.
+
+template <typename Barrier, unsigned NThreads>
+void barrierPhase(benchmark::State & state)
+{
+    static Barrier barrier(NThreads);
+    for (auto _ : state)
+    {
+        barrier.arrive_and_wait();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <unsigned NThreads>
+void BM_TreeBarrier(benchmark::State & state)
+{
+    static cm::TreeBarrier barrier(NThreads);
+    const auto id = static_cast<unsigned>(state.thread_index());
+    for (auto _ : state)
+    {
+        barrier.arrive_and_wait(id);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define CM_BENCH_BARRIER(NTHREADS)                                                                                               \
+    BENCHMARK_TEMPLATE(barrierPhase, cm::SpinLockBarrier, NTHREADS)->Threads(NTHREADS)->UseRealTime();                           \
+    BENCHMARK_TEMPLATE(barrierPhase, cm::Barrier, NTHREADS)->Threads(NTHREADS)->UseRealTime();                                   \
+    BENCHMARK_TEMPLATE(barrierPhase, cm::BasicFlexBarrier<cm::noCompletion>, NTHREADS)->Threads(NTHREADS)->UseRealTime();        \
+    BENCHMARK_TEMPLATE(barrierPhase, cm::HybridBarrier, NTHREADS)->Threads(NTHREADS)->UseRealTime();                             \
+    BENCHMARK_TEMPLATE(BM_TreeBarrier, NTHREADS)->Threads(NTHREADS)->UseRealTime()
+
+CM_BENCH_BARRIER(1);
+CM_BENCH_BARRIER(2);
+CM_BENCH_BARRIER(4);
+CM_BENCH_BARRIER(8);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct product
+{
+    virtual ~product() = default;
+};
+
+struct concreteProduct : product
+{
+};
+
+const cm::factoryRegisterer<concreteProduct, product> registerProduct("concreteProduct");
+
+void BM_Factory_create_hit(benchmark::State & state)
+{
+    auto & factory = cm::Factory<product>::instance();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(factory.create("concreteProduct"));
+    }
+}
+
+void BM_Factory_create_miss(benchmark::State & state)
+{
+    auto & factory = cm::Factory<product>::instance();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(factory.create("missingProduct"));
+    }
+}
+
+void BM_Factory_create_handle(benchmark::State & state)
+{
+    auto & factory = cm::Factory<product>::instance();
+    const auto handle = factory.find("concreteProduct");
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(factory.create(handle));
+    }
+}
+
+BENCHMARK(BM_Factory_create_hit);
+BENCHMARK(BM_Factory_create_miss);
+BENCHMARK(BM_Factory_create_handle);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// numeric
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BM_linspace(benchmark::State & state)
+{
+    const auto num = static_cast<size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cm::linspace(0.0, 1.0, num).data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_geomspace(benchmark::State & state)
+{
+    const auto num = static_cast<size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cm::geomspace(1.0, 1000.0, num).data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_linspace_into(benchmark::State & state)
+{
+    std::vector<double> out(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        cm::linspace_into(out.data(), 0.0, 1.0, out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_linspace)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK(BM_geomspace)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK(BM_linspace_into)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// functional
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A fold that is not a plain sum, so every element has to pass through the folding function; checked on every run.
+void BM_pairwise_accumulate_sumOfSquares(benchmark::State & state)
+{
+    const std::vector<double> values(static_cast<size_t>(state.range(0)), 2.0);
+    const double expected = 4.0 * static_cast<double>(values.size());
+
+    for (auto _ : state)
+    {
+        double sum = cm::pairwise_accumulate(
+            values.begin(), values.end(), 0.0, [](double acc, double x) { return acc + x * x; },
+            [](double lhs, double rhs) { return lhs + rhs; });
+        if (sum != expected)
+        {
+            state.SkipWithError("pairwise_accumulate: wrong sum of squares");
+            break;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_pairwise_accumulate_sumOfSquares)->RangeMultiplier(16)->Range(1 << 6, 1 << 20);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// stack backends
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Stack>
+void fillAndDrain(benchmark::State & state, Stack & stack)
+{
+    const auto n = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            stack.push(i);
+        }
+        int sum = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            sum += stack.top();
+            stack.pop();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Stack_deque(benchmark::State & state)
+{
+    cm::Stack<int> stack;
+    fillAndDrain(state, stack);
+}
+
+void BM_Stack_StackContainer(benchmark::State & state)
+{
+    // the slot 0 stays unused
+    cm::Stack<int, cm::StackContainer<int>> stack(cm::StackContainer<int>(static_cast<size_t>(state.range(0)) + 1));
+    fillAndDrain(state, stack);
+}
+
+void BM_Stack_InlineStackContainer(benchmark::State & state)
+{
+    cm::Stack<int, cm::InlineStackContainer<int, 64, cm::geometricGrowth>> stack;
+    fillAndDrain(state, stack);
+}
+
+BENCHMARK(BM_Stack_deque)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_Stack_StackContainer)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_Stack_InlineStackContainer)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+} // namespace
+
+BENCHMARK_MAIN();
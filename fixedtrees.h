@@ -0,0 +1,273 @@
+/** \file fixedtrees.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Recombinant trees of compile-time depth.
+ */
+
+#ifndef CM_FIXEDTREES_H
+#define CM_FIXEDTREES_H
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include <common/trees.h>
+
+namespace cm
+{
+
+//! \brief A recombinantBTree of compile-time depth.
+//! The nodes are stored in a std::array, so no heap allocation; mind the stack for larger depths.
+//! The geometry is that of recombinantBGeometry in integer arithmetic only, without the floating-point square root;
+//! constexpr throughout, which also lets the compiler unroll the level loops.
+//! Same addressing as recombinantBTree, hence usable with nodeRef, levelNodes & parallelBackwardInduction.
+//! \tparam Depth - number of sub-levels, [0, inf). Root is level 0!
+template <typename Node, size_t Depth>
+class fixedRecombinantBTree : public basicRecombinantBGeometry<detail::integerRoot>
+{
+public:
+    using value_type = Node;
+    static constexpr size_t depth = Depth;
+
+    using geometry = basicRecombinantBGeometry<detail::integerRoot>;
+
+    //! @name Geometry
+    //! The index arithmetic is inherited from the geometry, all of it constexpr.
+    ///@{
+    //! \brief The number of total levels - the depth of the tree + 1.
+    static constexpr size_t numLevels();
+    //! \brief The total number of elements in the tree.
+    static constexpr size_t totalElems();
+    ///@}
+
+    constexpr Node & operator[](size_t ind);
+    constexpr const Node & operator[](size_t ind) const;
+
+    //! \brief The begin iterator of the underlying structure.
+    constexpr auto begin();
+    //! \brief The end iterator of the underlying structure.
+    constexpr auto end();
+
+    constexpr Node & root();
+    constexpr const Node & root() const;
+
+    //! \brief The contiguous storage of \p level, starting at its left boundary.
+    constexpr Node * levelData(size_t level);
+    constexpr const Node * levelData(size_t level) const;
+
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! Unlike the runtime trees' it is not profiled, the instrumentation of tools.h can't be used in a constexpr function.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    constexpr void backwardInduction(Kernel && kernel);
+
+private:
+    std::array<Node, geometry::numElems(Depth)> m_data{};
+};
+
+
+//! \brief A recombinantTTree of compile-time depth.
+//! \see fixedRecombinantBTree
+//! \tparam Depth - number of sub-levels, [0, inf). Root is level 0!
+template <typename Node, size_t Depth>
+class fixedRecombinantTTree : public basicRecombinantTGeometry<detail::integerRoot>
+{
+public:
+    using value_type = Node;
+    static constexpr size_t depth = Depth;
+
+    using geometry = basicRecombinantTGeometry<detail::integerRoot>;
+
+    //! @name Geometry
+    //! The index arithmetic is inherited from the geometry, all of it constexpr.
+    ///@{
+    //! \brief The number of total levels - the depth of the tree + 1.
+    static constexpr size_t numLevels();
+    //! \brief The total number of elements in the tree.
+    static constexpr size_t totalElems();
+    ///@}
+
+    constexpr Node & operator[](size_t ind);
+    constexpr const Node & operator[](size_t ind) const;
+
+    //! \brief The begin iterator of the underlying structure.
+    constexpr auto begin();
+    //! \brief The end iterator of the underlying structure.
+    constexpr auto end();
+
+    constexpr Node & root();
+    constexpr const Node & root() const;
+
+    //! \brief The contiguous storage of \p level, starting at its left boundary.
+    constexpr Node * levelData(size_t level);
+    constexpr const Node * levelData(size_t level) const;
+
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! Unlike the runtime trees' it is not profiled, the instrumentation of tools.h can't be used in a constexpr function.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    constexpr void backwardInduction(Kernel && kernel);
+
+private:
+    std::array<Node, geometry::numElems(Depth)> m_data{};
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+// fixedRecombinantBTree
+
+template <typename Node, size_t Depth>
+constexpr size_t fixedRecombinantBTree<Node, Depth>::numLevels()
+{
+    return Depth + 1;
+}
+
+template <typename Node, size_t Depth>
+constexpr size_t fixedRecombinantBTree<Node, Depth>::totalElems()
+{
+    return numElems(Depth);
+}
+
+template <typename Node, size_t Depth>
+constexpr Node & fixedRecombinantBTree<Node, Depth>::operator[](size_t ind)
+{
+    return m_data[ind];
+}
+
+template <typename Node, size_t Depth>
+constexpr const Node & fixedRecombinantBTree<Node, Depth>::operator[](size_t ind) const
+{
+    return m_data[ind];
+}
+
+template <typename Node, size_t Depth>
+constexpr auto fixedRecombinantBTree<Node, Depth>::begin()
+{
+    return m_data.begin();
+}
+
+template <typename Node, size_t Depth>
+constexpr auto fixedRecombinantBTree<Node, Depth>::end()
+{
+    return m_data.end();
+}
+
+template <typename Node, size_t Depth>
+constexpr Node & fixedRecombinantBTree<Node, Depth>::root()
+{
+    return m_data[0];
+}
+
+template <typename Node, size_t Depth>
+constexpr const Node & fixedRecombinantBTree<Node, Depth>::root() const
+{
+    return m_data[0];
+}
+
+template <typename Node, size_t Depth>
+constexpr Node * fixedRecombinantBTree<Node, Depth>::levelData(size_t level)
+{
+    return m_data.data() + left_boundary(level);
+}
+
+template <typename Node, size_t Depth>
+constexpr const Node * fixedRecombinantBTree<Node, Depth>::levelData(size_t level) const
+{
+    return m_data.data() + left_boundary(level);
+}
+
+template <typename Node, size_t Depth>
+template <typename Kernel>
+constexpr void fixedRecombinantBTree<Node, Depth>::backwardInduction(Kernel && kernel)
+{
+    for (size_t l = Depth; l-- > 0;)
+    {
+        Node * current = m_data.data() + left_boundary(l);
+        kernel(levelSpan<Node>{l, 0, l + 1, current, current + l + 1});
+    }
+}
+
+
+// fixedRecombinantTTree
+
+template <typename Node, size_t Depth>
+constexpr size_t fixedRecombinantTTree<Node, Depth>::numLevels()
+{
+    return Depth + 1;
+}
+
+template <typename Node, size_t Depth>
+constexpr size_t fixedRecombinantTTree<Node, Depth>::totalElems()
+{
+    return numElems(Depth);
+}
+
+template <typename Node, size_t Depth>
+constexpr Node & fixedRecombinantTTree<Node, Depth>::operator[](size_t ind)
+{
+    return m_data[ind];
+}
+
+template <typename Node, size_t Depth>
+constexpr const Node & fixedRecombinantTTree<Node, Depth>::operator[](size_t ind) const
+{
+    return m_data[ind];
+}
+
+template <typename Node, size_t Depth>
+constexpr auto fixedRecombinantTTree<Node, Depth>::begin()
+{
+    return m_data.begin();
+}
+
+template <typename Node, size_t Depth>
+constexpr auto fixedRecombinantTTree<Node, Depth>::end()
+{
+    return m_data.end();
+}
+
+template <typename Node, size_t Depth>
+constexpr Node & fixedRecombinantTTree<Node, Depth>::root()
+{
+    return m_data[0];
+}
+
+template <typename Node, size_t Depth>
+constexpr const Node & fixedRecombinantTTree<Node, Depth>::root() const
+{
+    return m_data[0];
+}
+
+template <typename Node, size_t Depth>
+constexpr Node * fixedRecombinantTTree<Node, Depth>::levelData(size_t level)
+{
+    return m_data.data() + left_boundary(level);
+}
+
+template <typename Node, size_t Depth>
+constexpr const Node * fixedRecombinantTTree<Node, Depth>::levelData(size_t level) const
+{
+    return m_data.data() + left_boundary(level);
+}
+
+template <typename Node, size_t Depth>
+template <typename Kernel>
+constexpr void fixedRecombinantTTree<Node, Depth>::backwardInduction(Kernel && kernel)
+{
+    for (size_t l = Depth; l-- > 0;)
+    {
+        Node * current = m_data.data() + left_boundary(l);
+        kernel(levelSpan<Node>{l, 0, 2 * l + 1, current, current + 2 * l + 1});
+    }
+}
+
+} // namespace cm
+
+#endif // CM_FIXEDTREES_H
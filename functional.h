@@ -6,8 +6,13 @@
 #ifndef CFUNCTIONAL_H
 #define CFUNCTIONAL_H
 
+#include <algorithm>
 #include <any>
+#include <cstddef>
 #include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace cm
@@ -28,6 +33,27 @@ namespace cm
 template <typename BeginIt, typename EndIt, typename T, typename F>
 T moving_accumulate(BeginIt first, const EndIt & last, T init, F folding_function);
 
+//! \brief A moving_accumulate that folds blocks of the range separately & combines the partial results pairwise.
+//! For floating-point sums the rounding error then grows as \f$\mathcal{O}(\log n)\f$ instead of \f$\mathcal{O}(n)\f$,
+//! & the independent blocks give the compiler a tight loop to vectorize.
+//! A range of up to \p block_size elements is folded from \p init directly. Otherwise each block's fold starts from
+//! \p identity & every element goes through \p folding_function, so \p combine has to be associative
+//! with \p identity as its neutral element, e.g. 0 for a sum.
+//! \param first iterator to first element
+//! \param last  iterator to last element
+//! \param init  initial value, combined with the total
+//! \param folding_function (T, element) -> T
+//! \param combine (T, T) -> T, joins two partial results
+//! \param block_size the number of elements folded sequentially
+//! \param identity the neutral element of \p combine, the start of each block
+//! \return the accumulated values
+template <typename It, typename T, typename F, typename C>
+T pairwise_accumulate(It first, It last, T init, F folding_function, C combine, size_t block_size = 128, T identity = T{});
+
+//! \brief pairwise_accumulate with the folding function combining the partial results as well, e.g. a sum.
+template <typename It, typename T, typename F>
+T pairwise_accumulate(It first, It last, T init, F folding_function);
+
 //! \brief Wrapper around std::any for std::functions.
 // Adapted from c.f.: https://stackoverflow.com/questions/45715219/store-functions-with-different-signatures-in-a-map/
 // WARNING: Had trouble compiling with libc++ 9.0 on Linux.
@@ -70,6 +96,142 @@ struct AnyCallable<void>
 };
 
 
+namespace detail
+{
+
+template <typename... Args>
+struct typeList
+{};
+
+// the parameters of a non-overloaded callable
+template <typename F>
+struct callableSignature : callableSignature<decltype(&F::operator())>
+{};
+
+template <typename R, typename... Args>
+struct callableSignature<R (*)(Args...)>
+{
+    using args = typeList<Args...>;
+};
+
+template <typename R, typename... Args>
+struct callableSignature<R (*)(Args...) noexcept> : callableSignature<R (*)(Args...)>
+{};
+
+template <typename C, typename R, typename... Args>
+struct callableSignature<R (C::*)(Args...)> : callableSignature<R (*)(Args...)>
+{};
+
+template <typename C, typename R, typename... Args>
+struct callableSignature<R (C::*)(Args...) const> : callableSignature<R (*)(Args...)>
+{};
+
+template <typename C, typename R, typename... Args>
+struct callableSignature<R (C::*)(Args...) noexcept> : callableSignature<R (*)(Args...)>
+{};
+
+template <typename C, typename R, typename... Args>
+struct callableSignature<R (C::*)(Args...) const noexcept> : callableSignature<R (*)(Args...)>
+{};
+
+// a unique address per signature, compared instead of the RTTI
+template <typename... Args>
+struct signatureTag
+{
+    static constexpr char id = 0;
+};
+
+} // namespace detail
+
+//! \brief A callable of \p Ret(Args...) bound to a SmallCallable, calling it without any checks.
+template <typename Ret, typename... Args>
+class boundCallable
+{
+public:
+    using thunk_type = Ret (*)(void *, Args &&...);
+
+    boundCallable() = default;
+    boundCallable(void * p_object, thunk_type p_thunk) : m_object(p_object), m_thunk(p_thunk) {}
+
+    Ret operator()(Args... args) const { return m_thunk(m_object, std::forward<Args>(args)...); }
+    explicit operator bool() const noexcept { return m_thunk != nullptr; }
+
+private:
+    void * m_object{nullptr};
+    thunk_type m_thunk{nullptr};
+};
+
+//! \brief A type-erased callable returning \p Ret, of any signature, stored in-place.
+//! As AnyCallable, it holds a callable of any parameter list; but without an allocation, \see Capacity, & invoked via
+//! a single function pointer. The signature is checked by a pointer comparison, on each checked call or once on bind().
+//! As with AnyCallable, the arguments have to match the callable's parameter types exactly.
+//! \tparam Capacity: the in-place storage size; larger callables are rejected at compile-time.
+template <typename Ret, size_t Capacity = 4 * sizeof(void *)>
+class SmallCallable
+{
+public:
+    SmallCallable() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SmallCallable>>>
+    SmallCallable(F && fun);
+
+    SmallCallable(const SmallCallable & other);
+    SmallCallable(SmallCallable && other) noexcept;
+    SmallCallable & operator=(const SmallCallable & other);
+    SmallCallable & operator=(SmallCallable && other) noexcept;
+    ~SmallCallable();
+
+    explicit operator bool() const noexcept { return m_thunk != nullptr; }
+
+    //! \brief Whether the stored callable takes \p Args.
+    template <typename... Args>
+    bool accepts() const noexcept;
+
+    //! \brief Calls the stored callable, throws std::bad_function_call if empty or of a different signature.
+    template <typename... Args>
+    Ret operator()(Args &&... args) const;
+
+    //! \brief Calls the stored callable, which has to take exactly \p Args.
+    template <typename... Args>
+    Ret call_unchecked(Args &&... args) const;
+
+    //! \brief Checks the signature once, for repeated unchecked calls.
+    //! \return An empty boundCallable if the stored callable doesn't take \p Args.
+    //! NOTE: it refers to this instance & is invalidated when this is modified or destroyed.
+    template <typename... Args>
+    boundCallable<Ret, Args...> bind() const noexcept;
+
+private:
+    enum class operation
+    {
+        copy,
+        move,
+        destroy
+    };
+
+    using thunk_type = void (*)();
+    using manager_type = void (*)(operation, void *, void *);
+
+    template <typename F, typename... Args>
+    static Ret invoke(void * p_object, Args &&... args);
+
+    template <typename F>
+    static void manage(operation p_op, void * p_src, void * p_dst);
+
+    template <typename F, typename... Args>
+    void store(F && fun, detail::typeList<Args...>);
+
+    void * object() const noexcept { return const_cast<unsigned char *>(m_storage); }
+    void reset() noexcept;
+
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+    // the actual type is Ret (*)(void *, Args &&...)
+    thunk_type m_thunk{nullptr};
+    const void * m_signature{nullptr};
+    manager_type m_manager{nullptr};
+};
+
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //  IMPLEMENTATION
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -91,6 +253,49 @@ T moving_accumulate(BeginIt first, const EndIt & last, T init, F folding_functio
     return init;
 }
 
+namespace detail
+{
+
+// n > 0, every block starts from identity
+template <typename It, typename T, typename F, typename C>
+T pairwiseFold(It first, size_t n, F & folding_function, C & combine, size_t block_size, const T & identity)
+{
+    if (n <= block_size)
+    {
+        return moving_accumulate(first, std::next(first, static_cast<std::ptrdiff_t>(n)), identity, std::ref(folding_function));
+    }
+
+    size_t half = n / 2;
+    T left = pairwiseFold<It, T>(first, half, folding_function, combine, block_size, identity);
+    T right = pairwiseFold<It, T>(std::next(first, static_cast<std::ptrdiff_t>(half)), n - half, folding_function, combine,
+                                  block_size, identity);
+
+    return combine(std::move(left), std::move(right));
+}
+
+} // namespace detail
+
+template <typename It, typename T, typename F, typename C>
+T pairwise_accumulate(It first, It last, T init, F folding_function, C combine, size_t block_size, T identity)
+{
+    auto n = std::distance(first, last);
+    block_size = std::max<size_t>(block_size, 1);
+    if (n <= static_cast<std::ptrdiff_t>(block_size))
+    {
+        // a single block, no partial results to combine
+        return moving_accumulate(first, last, std::move(init), folding_function);
+    }
+
+    T total = detail::pairwiseFold<It, T>(first, static_cast<size_t>(n), folding_function, combine, block_size, identity);
+    return combine(std::move(init), std::move(total));
+}
+
+template <typename It, typename T, typename F>
+T pairwise_accumulate(It first, It last, T init, F folding_function)
+{
+    return pairwise_accumulate(first, last, std::move(init), folding_function, folding_function);
+}
+
 
 // AnyCallable
 template <typename Ret>
@@ -125,6 +330,165 @@ void AnyCallable<void>::operator()(Args &&... args)
     std::invoke(std::any_cast<std::function<void(Args...)>>(m_any), std::forward<Args>(args)...);
 }
 
+
+// SmallCallable
+template <typename Ret, size_t Capacity>
+template <typename F, typename>
+SmallCallable<Ret, Capacity>::SmallCallable(F && fun)
+{
+    using Fn = std::decay_t<F>;
+    static_assert(sizeof(Fn) <= Capacity, "The callable does not fit into the SmallCallable's Capacity");
+    static_assert(alignof(Fn) <= alignof(std::max_align_t), "The callable is over-aligned");
+    static_assert(std::is_copy_constructible_v<Fn>, "The callable has to be copyable");
+
+    store(std::forward<F>(fun), typename detail::callableSignature<Fn>::args{});
+}
+
+template <typename Ret, size_t Capacity>
+template <typename F, typename... Args>
+void SmallCallable<Ret, Capacity>::store(F && fun, detail::typeList<Args...>)
+{
+    using Fn = std::decay_t<F>;
+
+    ::new (object()) Fn(std::forward<F>(fun));
+    m_thunk = reinterpret_cast<thunk_type>(&SmallCallable::invoke<Fn, Args...>);
+    m_signature = &detail::signatureTag<Args...>::id;
+    m_manager = &SmallCallable::manage<Fn>;
+}
+
+template <typename Ret, size_t Capacity>
+template <typename F, typename... Args>
+Ret SmallCallable<Ret, Capacity>::invoke(void * p_object, Args &&... args)
+{
+    return std::invoke(*static_cast<F *>(p_object), std::forward<Args>(args)...);
+}
+
+template <typename Ret, size_t Capacity>
+template <typename F>
+void SmallCallable<Ret, Capacity>::manage(operation p_op, void * p_src, void * p_dst)
+{
+    switch (p_op)
+    {
+    case operation::copy:
+        ::new (p_dst) F(*static_cast<const F *>(p_src));
+        break;
+    case operation::move:
+        ::new (p_dst) F(std::move(*static_cast<F *>(p_src)));
+        static_cast<F *>(p_src)->~F();
+        break;
+    case operation::destroy:
+        static_cast<F *>(p_src)->~F();
+        break;
+    }
+}
+
+template <typename Ret, size_t Capacity>
+SmallCallable<Ret, Capacity>::SmallCallable(const SmallCallable & other)
+{
+    if (other.m_manager)
+    {
+        other.m_manager(operation::copy, other.object(), object());
+        m_thunk = other.m_thunk;
+        m_signature = other.m_signature;
+        m_manager = other.m_manager;
+    }
+}
+
+template <typename Ret, size_t Capacity>
+SmallCallable<Ret, Capacity>::SmallCallable(SmallCallable && other) noexcept
+{
+    // the stored callables are copyable, their moves are assumed not to throw
+    if (other.m_manager)
+    {
+        other.m_manager(operation::move, other.object(), object());
+        m_thunk = std::exchange(other.m_thunk, nullptr);
+        m_signature = std::exchange(other.m_signature, nullptr);
+        m_manager = std::exchange(other.m_manager, nullptr);
+    }
+}
+
+template <typename Ret, size_t Capacity>
+SmallCallable<Ret, Capacity> & SmallCallable<Ret, Capacity>::operator=(const SmallCallable & other)
+{
+    if (this != &other)
+    {
+        SmallCallable copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+template <typename Ret, size_t Capacity>
+SmallCallable<Ret, Capacity> & SmallCallable<Ret, Capacity>::operator=(SmallCallable && other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        if (other.m_manager)
+        {
+            other.m_manager(operation::move, other.object(), object());
+            m_thunk = std::exchange(other.m_thunk, nullptr);
+            m_signature = std::exchange(other.m_signature, nullptr);
+            m_manager = std::exchange(other.m_manager, nullptr);
+        }
+    }
+    return *this;
+}
+
+template <typename Ret, size_t Capacity>
+SmallCallable<Ret, Capacity>::~SmallCallable()
+{
+    reset();
+}
+
+template <typename Ret, size_t Capacity>
+void SmallCallable<Ret, Capacity>::reset() noexcept
+{
+    if (m_manager)
+    {
+        m_manager(operation::destroy, object(), nullptr);
+        m_thunk = nullptr;
+        m_signature = nullptr;
+        m_manager = nullptr;
+    }
+}
+
+template <typename Ret, size_t Capacity>
+template <typename... Args>
+bool SmallCallable<Ret, Capacity>::accepts() const noexcept
+{
+    return m_signature == &detail::signatureTag<Args...>::id;
+}
+
+template <typename Ret, size_t Capacity>
+template <typename... Args>
+Ret SmallCallable<Ret, Capacity>::operator()(Args &&... args) const
+{
+    if (!accepts<Args...>())
+    {
+        throw std::bad_function_call();
+    }
+    return call_unchecked<Args...>(std::forward<Args>(args)...);
+}
+
+template <typename Ret, size_t Capacity>
+template <typename... Args>
+Ret SmallCallable<Ret, Capacity>::call_unchecked(Args &&... args) const
+{
+    return reinterpret_cast<Ret (*)(void *, Args &&...)>(m_thunk)(object(), std::forward<Args>(args)...);
+}
+
+template <typename Ret, size_t Capacity>
+template <typename... Args>
+boundCallable<Ret, Args...> SmallCallable<Ret, Capacity>::bind() const noexcept
+{
+    if (!accepts<Args...>())
+    {
+        return {};
+    }
+    return {object(), reinterpret_cast<Ret (*)(void *, Args &&...)>(m_thunk)};
+}
+
 } // namespace cm
 
 #endif // CFUNCTIONAL_H
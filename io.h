@@ -6,25 +6,319 @@
 #ifndef IO_H
 #define IO_H
 
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <istream>
+#include <limits>
+#include <memory>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <vector>
 
+namespace cm
+{
+
+template <typename Node, typename Alloc>
+class bTree;
+
+namespace detail
+{
+//! \brief Whether \p T gets formatted by std::to_chars. The character types & bool are printed differently by the streams.
+template <typename T>
+constexpr bool toCharsFormattable
+    = std::is_floating_point_v<T>
+      || (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> && !std::is_same_v<T, signed char>
+          && !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char16_t>
+          && !std::is_same_v<T, char32_t>);
+} // namespace detail
+
+//! \brief A text formatter of arithmetic vectors, based on std::to_chars.
+//! Formats as "{a, b, c}" into a buffer reused between the calls, so a whole vector costs a single write.
+class textFormatter
+{
+public:
+    //! \brief textFormatter
+    //! \param format - the format of the floating point values
+    //! \param precision - the precision of the floating point values, negative for the shortest round-trip representation
+    explicit textFormatter(std::chars_format format = std::chars_format::general, int precision = -1)
+        : m_format(format)
+        , m_precision(precision)
+    {
+    }
+
+    //! \brief Formats \p vec into the buffer.
+    //! \return A view of the buffer, valid until the next call.
+    template <typename T, typename Alloc>
+    std::string_view format(const std::vector<T, Alloc> & vec);
+
+    //! \brief Formats \p vec & writes it to \p os in one go.
+    template <typename T, typename Alloc>
+    void write(std::ostream & os, const std::vector<T, Alloc> & vec);
+
+private:
+    template <typename T>
+    void append(T value);
+    void appendText(std::string_view str);
+
+    std::string m_buffer;
+    size_t m_size{0};
+    std::chars_format m_format;
+    int m_precision;
+};
+
+//! @name Binary dumps
+//! A small header followed by the raw contiguous bytes, so dumping & loading are a single block write or read.
+//! The representation is that of the host, so the dumps are not portable across architectures.
+///@{
+
+//! \brief The header of the binary dumps.
+struct binaryHeader
+{
+    static constexpr char magicValue[4] = {'c', 'm', 'b', '1'};
+
+    char magic[4];
+    //! \brief sizeof the element.
+    std::uint32_t elemSize;
+    //! \brief The number of elements.
+    std::uint64_t count;
+    //! \brief The depth of a dumped tree, 0 for plain arrays.
+    std::uint64_t depth;
+};
+
+//! \brief Dumps the contents of \p vec to \p os.
+template <typename T, typename Alloc>
+void dump(std::ostream & os, const std::vector<T, Alloc> & vec);
+//! \brief Loads a dump of dump(std::ostream &, const std::vector &) from \p is, replacing the contents of \p vec.
+template <typename T, typename Alloc>
+void load(std::istream & is, std::vector<T, Alloc> & vec);
+
+//! \brief Dumps the storage of \p tree to \p os.
+template <typename Node, typename Alloc>
+void dump(std::ostream & os, const bTree<Node, Alloc> & tree);
+//! \brief Loads a tree dump from \p is into \p tree, which must be of the same shape & depth as the one dumped.
+template <typename Node, typename Alloc>
+void load(std::istream & is, bTree<Node, Alloc> & tree);
+///@}
+
+} // namespace cm
+
 //! \brief Overload for easy printing of std::vector contents.
+//! The arithmetic types go through cm::textFormatter, honouring the float field & the precision of \p os.
 //! \param os
 //! \param vec
 //! \return
 
 // NOTE: in global namespace!
+template <class T>
+std::ostream & operator<<(std::ostream & os, const std::vector<T> & vec);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace cm
+{
+
+template <typename T, typename Alloc>
+std::string_view textFormatter::format(const std::vector<T, Alloc> & vec)
+{
+    static_assert(detail::toCharsFormattable<T>, "textFormatter formats arithmetic types only");
+
+    // a guess, the buffer grows as needed
+    constexpr size_t elemChars = std::is_floating_point_v<T> ? 24 : std::numeric_limits<T>::digits10 + 2;
+    m_buffer.resize(std::max(m_buffer.size(), vec.size() * (elemChars + 2) + 2));
+    m_size = 0;
+
+    appendText("{");
+    for (size_t i = 0; i < vec.size(); ++i)
+    {
+        if (i)
+        {
+            appendText(", ");
+        }
+        append(vec[i]);
+    }
+    appendText("}");
+
+    return std::string_view(m_buffer.data(), m_size);
+}
+
+template <typename T, typename Alloc>
+void textFormatter::write(std::ostream & os, const std::vector<T, Alloc> & vec)
+{
+    const std::string_view str = format(vec);
+    os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+template <typename T>
+void textFormatter::append(T value)
+{
+    for (;;)
+    {
+        char * first = m_buffer.data() + m_size;
+        char * last = m_buffer.data() + m_buffer.size();
+
+        std::to_chars_result res;
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            res = m_precision < 0 ? std::to_chars(first, last, value, m_format)
+                                  : std::to_chars(first, last, value, m_format, m_precision);
+        }
+        else
+        {
+            res = std::to_chars(first, last, value);
+        }
+
+        if (res.ec == std::errc{})
+        {
+            m_size = static_cast<size_t>(res.ptr - m_buffer.data());
+            return;
+        }
+        m_buffer.resize(std::max<size_t>(2 * m_buffer.size(), 64));
+    }
+}
+
+inline void textFormatter::appendText(std::string_view str)
+{
+    if (m_size + str.size() > m_buffer.size())
+    {
+        m_buffer.resize(std::max(2 * m_buffer.size(), m_size + str.size()));
+    }
+    std::memcpy(m_buffer.data() + m_size, str.data(), str.size());
+    m_size += str.size();
+}
+
+namespace detail
+{
+template <typename T>
+void dumpRaw(std::ostream & os, const T * data, size_t count, size_t depth)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be dumped");
+
+    binaryHeader header{};
+    std::memcpy(header.magic, binaryHeader::magicValue, sizeof(header.magic));
+    header.elemSize = sizeof(T);
+    header.count = count;
+    header.depth = depth;
+
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    if (!os)
+    {
+        throw std::range_error("dump: write failed");
+    }
+}
+
+template <typename T>
+binaryHeader loadHeader(std::istream & is)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be loaded");
+
+    binaryHeader header{};
+    is.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!is || std::memcmp(header.magic, binaryHeader::magicValue, sizeof(header.magic)) != 0)
+    {
+        throw std::range_error("load: not a binary dump");
+    }
+    if (header.elemSize != sizeof(T))
+    {
+        throw std::range_error("load: element size mismatch");
+    }
+    return header;
+}
+
+template <typename T>
+void loadRaw(std::istream & is, T * data, size_t count)
+{
+    is.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    if (!is)
+    {
+        throw std::range_error("load: truncated dump");
+    }
+}
+} // namespace detail
+
+template <typename T, typename Alloc>
+void dump(std::ostream & os, const std::vector<T, Alloc> & vec)
+{
+    detail::dumpRaw(os, vec.data(), vec.size(), 0);
+}
+
+template <typename T, typename Alloc>
+void load(std::istream & is, std::vector<T, Alloc> & vec)
+{
+    const binaryHeader header = detail::loadHeader<T>(is);
+    vec.resize(header.count);
+    detail::loadRaw(is, vec.data(), vec.size());
+}
+
+template <typename Node, typename Alloc>
+void dump(std::ostream & os, const bTree<Node, Alloc> & tree)
+{
+    detail::dumpRaw(os, &tree[0], tree.totalElems(), tree.numLevels() - 1);
+}
+
+template <typename Node, typename Alloc>
+void load(std::istream & is, bTree<Node, Alloc> & tree)
+{
+    const binaryHeader header = detail::loadHeader<Node>(is);
+    if (header.depth != tree.numLevels() - 1 || header.count != tree.totalElems())
+    {
+        throw std::range_error("load: tree shape mismatch");
+    }
+    detail::loadRaw(is, &tree[0], tree.totalElems());
+}
+
+} // namespace cm
+
 template <class T>
 std::ostream & operator<<(std::ostream & os, const std::vector<T> & vec)
 {
+    if constexpr (cm::detail::toCharsFormattable<T>)
+    {
+        // the formatter covers the float field & the precision, for anything else fall through;
+        // hexfloat too, as to_chars leaves out the 0x prefix that the stream prints
+        constexpr auto formatted = std::ios_base::floatfield | std::ios_base::skipws | std::ios_base::dec;
+        const auto floatfield = os.flags() & std::ios_base::floatfield;
+        if ((os.flags() & ~formatted) == std::ios_base::fmtflags{} && os.width() == 0
+            && (os.flags() & std::ios_base::basefield) == std::ios_base::dec && floatfield != std::ios_base::floatfield)
+        {
+            std::chars_format format = std::chars_format::general;
+            int precision = static_cast<int>(os.precision());
+            if (floatfield == std::ios_base::fixed)
+            {
+                format = std::chars_format::fixed;
+            }
+            else if (floatfield == std::ios_base::scientific)
+            {
+                format = std::chars_format::scientific;
+            }
+
+            cm::textFormatter(format, precision).write(os, vec);
+            return os;
+        }
+    }
+
     os << "{";
-    for (auto it = vec.begin(); it != vec.end() - 1; ++it)
+    for (auto it = vec.begin(); it != vec.end(); ++it)
     {
-        os << *it << ", ";
+        if (it != vec.begin())
+        {
+            os << ", ";
+        }
+        os << *it;
     }
-    os << *(vec.end() - 1) << "}";
+    os << "}";
     return os;
 }
 
@@ -5,7 +5,408 @@
 
 #include "numeric.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CM_X86_KERNELS
+#include <immintrin.h>
+#endif
+
 namespace cm
 {
 
+namespace
+{
+
+// the sums are split in blocks of this size, which are summed pairwise
+constexpr size_t pairwiseBlock = 256;
+
+struct kernels
+{
+    simdLevel level;
+    double (*blockSum)(const double *, size_t);
+    double (*kahanSum)(const double *, size_t);
+    double (*dot)(const double *, const double *, size_t);
+    void (*axpy)(double, const double *, double *, size_t);
+    void (*discountedExpectation)(double, double, const double *, double *, size_t);
+};
+
+double pairwise(const double * x, size_t n, double (*p_blockSum)(const double *, size_t))
+{
+    if (n <= pairwiseBlock)
+    {
+        return p_blockSum(x, n);
+    }
+    size_t half = n / 2;
+    return pairwise(x, half, p_blockSum) + pairwise(x + half, n - half, p_blockSum);
+}
+
+// the compensated addition of p_value to p_sum
+inline void kahanAdd(double & p_sum, double & p_compensation, double p_value)
+{
+    double y = p_value - p_compensation;
+    double t = p_sum + y;
+    p_compensation = (t - p_sum) - y;
+    p_sum = t;
+}
+
+
+// scalar
+
+double blockSumScalar(const double * x, size_t n)
+{
+    double ret = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        ret += x[i];
+    }
+    return ret;
+}
+
+// the tails of the vectorized kahan sums are finished in kahanFinish
+[[maybe_unused]] double kahanSumScalar(const double * x, size_t n)
+{
+    double sum = 0.0;
+    double compensation = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        kahanAdd(sum, compensation, x[i]);
+    }
+    return sum;
+}
+
+double dotScalar(const double * x, const double * y, size_t n)
+{
+    double ret = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        ret += x[i] * y[i];
+    }
+    return ret;
+}
+
+void axpyScalar(double a, const double * x, double * y, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        y[i] += a * x[i];
+    }
+}
+
+void discountedExpectationScalar(double a, double b, const double * x, double * out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = a * x[i] + b * x[i + 1];
+    }
+}
+
+// the remaining lanes of the vectorized kernels
+double kahanFinish(const double * p_sums, const double * p_compensations, size_t p_lanes, const double * x, size_t n)
+{
+    double sum = 0.0;
+    double compensation = 0.0;
+    for (size_t l = 0; l < p_lanes; ++l)
+    {
+        kahanAdd(sum, compensation, p_sums[l]);
+        kahanAdd(sum, compensation, -p_compensations[l]);
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        kahanAdd(sum, compensation, x[i]);
+    }
+    return sum;
+}
+
+
+#ifdef CM_X86_KERNELS
+
+// SSE2, the x86-64 baseline
+
+double blockSumSse2(const double * x, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(x + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(x + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + blockSumScalar(x + i, n - i);
+}
+
+double kahanSumSse2(const double * x, size_t n)
+{
+    __m128d sum = _mm_setzero_pd();
+    __m128d compensation = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d y = _mm_sub_pd(_mm_loadu_pd(x + i), compensation);
+        __m128d t = _mm_add_pd(sum, y);
+        compensation = _mm_sub_pd(_mm_sub_pd(t, sum), y);
+        sum = t;
+    }
+    double sums[2];
+    double compensations[2];
+    _mm_storeu_pd(sums, sum);
+    _mm_storeu_pd(compensations, compensation);
+    return kahanFinish(sums, compensations, 2, x + i, n - i);
+}
+
+double dotSse2(const double * x, const double * y, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + dotScalar(x + i, y + i, n - i);
+}
+
+void axpySse2(double a, const double * x, double * y, size_t n)
+{
+    __m128d va = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+    }
+    axpyScalar(a, x + i, y + i, n - i);
+}
+
+void discountedExpectationSse2(double a, double b, const double * x, double * out, size_t n)
+{
+    __m128d va = _mm_set1_pd(a);
+    __m128d vb = _mm_set1_pd(b);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        // both loads precede the store, so out == x is fine
+        __m128d current = _mm_loadu_pd(x + i);
+        __m128d next = _mm_loadu_pd(x + i + 1);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(va, current), _mm_mul_pd(vb, next)));
+    }
+    discountedExpectationScalar(a, b, x + i, out + i, n - i);
+}
+
+
+// AVX2 & FMA
+
+__attribute__((target("avx2,fma"))) double blockSumAvx2(const double * x, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + blockSumScalar(x + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) double kahanSumAvx2(const double * x, size_t n)
+{
+    __m256d sum = _mm256_setzero_pd();
+    __m256d compensation = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d y = _mm256_sub_pd(_mm256_loadu_pd(x + i), compensation);
+        __m256d t = _mm256_add_pd(sum, y);
+        compensation = _mm256_sub_pd(_mm256_sub_pd(t, sum), y);
+        sum = t;
+    }
+    double sums[4];
+    double compensations[4];
+    _mm256_storeu_pd(sums, sum);
+    _mm256_storeu_pd(compensations, compensation);
+    return kahanFinish(sums, compensations, 4, x + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) double dotAvx2(const double * x, const double * y, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotScalar(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) void axpyAvx2(double a, const double * x, double * y, size_t n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    axpyScalar(a, x + i, y + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) void discountedExpectationAvx2(double a, double b, const double * x, double * out,
+                                                                    size_t n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    __m256d vb = _mm256_set1_pd(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d current = _mm256_loadu_pd(x + i);
+        __m256d next = _mm256_loadu_pd(x + i + 1);
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(va, current, _mm256_mul_pd(vb, next)));
+    }
+    discountedExpectationScalar(a, b, x + i, out + i, n - i);
+}
+
+
+// AVX-512
+
+__attribute__((target("avx512f"))) double blockSumAvx512(const double * x, size_t n)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm512_add_pd(acc0, _mm512_loadu_pd(x + i));
+        acc1 = _mm512_add_pd(acc1, _mm512_loadu_pd(x + i + 8));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    return blockSumScalar(lanes, 8) + blockSumScalar(x + i, n - i);
+}
+
+__attribute__((target("avx512f"))) double kahanSumAvx512(const double * x, size_t n)
+{
+    __m512d sum = _mm512_setzero_pd();
+    __m512d compensation = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d y = _mm512_sub_pd(_mm512_loadu_pd(x + i), compensation);
+        __m512d t = _mm512_add_pd(sum, y);
+        compensation = _mm512_sub_pd(_mm512_sub_pd(t, sum), y);
+        sum = t;
+    }
+    double sums[8];
+    double compensations[8];
+    _mm512_storeu_pd(sums, sum);
+    _mm512_storeu_pd(compensations, compensation);
+    return kahanFinish(sums, compensations, 8, x + i, n - i);
+}
+
+__attribute__((target("avx512f"))) double dotAvx512(const double * x, const double * y, size_t n)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    return blockSumScalar(lanes, 8) + dotScalar(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void axpyAvx512(double a, const double * x, double * y, size_t n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+    }
+    axpyScalar(a, x + i, y + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void discountedExpectationAvx512(double a, double b, const double * x, double * out,
+                                                                     size_t n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    __m512d vb = _mm512_set1_pd(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d current = _mm512_loadu_pd(x + i);
+        __m512d next = _mm512_loadu_pd(x + i + 1);
+        _mm512_storeu_pd(out + i, _mm512_fmadd_pd(va, current, _mm512_mul_pd(vb, next)));
+    }
+    discountedExpectationScalar(a, b, x + i, out + i, n - i);
+}
+
+#endif // CM_X86_KERNELS
+
+const kernels & activeKernels() noexcept
+{
+    static const kernels ret = []() -> kernels {
+#ifdef CM_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            return {simdLevel::avx512, blockSumAvx512, kahanSumAvx512, dotAvx512, axpyAvx512, discountedExpectationAvx512};
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        {
+            return {simdLevel::avx2, blockSumAvx2, kahanSumAvx2, dotAvx2, axpyAvx2, discountedExpectationAvx2};
+        }
+        return {simdLevel::sse2, blockSumSse2, kahanSumSse2, dotSse2, axpySse2, discountedExpectationSse2};
+#else
+        return {simdLevel::scalar, blockSumScalar, kahanSumScalar, dotScalar, axpyScalar, discountedExpectationScalar};
+#endif
+    }();
+
+    return ret;
+}
+
+} // namespace
+
+
+simdLevel simd_level() noexcept
+{
+    return activeKernels().level;
+}
+
+double pairwise_sum(const double * x, size_t n) noexcept
+{
+    return pairwise(x, n, activeKernels().blockSum);
+}
+
+double kahan_sum(const double * x, size_t n) noexcept
+{
+    return activeKernels().kahanSum(x, n);
+}
+
+double dot(const double * x, const double * y, size_t n) noexcept
+{
+    return activeKernels().dot(x, y, n);
+}
+
+void axpy(double a, const double * x, double * y, size_t n) noexcept
+{
+    activeKernels().axpy(a, x, y, n);
+}
+
+void discounted_expectation(double a, double b, const double * x, double * out, size_t n) noexcept
+{
+    activeKernels().discountedExpectation(a, b, x, out, n);
+}
+
 } // namespace cm
@@ -10,7 +10,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 // TODO: * add axis param if you wish
@@ -49,6 +53,38 @@ std::vector<T> geomspace(T start, T stop, size_t num = 50, bool endpoint = true)
 template <typename T>
 std::vector<T> logspace(T start, T stop, size_t num, bool endpoint = true, double base = 10.0);
 
+//! \brief linspace writing the samples to \p out instead, e.g. a pointer to preallocated storage.
+//! Each sample is computed directly from its index, so the loop has no dependencies to keep it from vectorizing.
+//! \return the iterator past the last sample written
+template <typename T, typename OutputIt>
+OutputIt linspace_into(OutputIt out, T start, T stop, size_t num = 50, bool endpoint = true);
+
+//! \brief geomspace writing the samples to \p out instead, \see linspace_into.
+//! The samples are \f$start \cdot (stop / start)^{i / n}\f$, without accumulating the round-off of repeated
+//! multiplication.
+template <typename T, typename OutputIt>
+OutputIt geomspace_into(OutputIt out, T start, T stop, size_t num = 50, bool endpoint = true);
+
+//! \brief logspace writing the samples to \p out instead, \see linspace_into.
+template <typename T, typename OutputIt>
+OutputIt logspace_into(OutputIt out, T start, T stop, size_t num, bool endpoint = true, double base = 10.0);
+
+//! \brief A lazy random-access range of \p num samples, each generated on access by \p Fn from its index.
+template <typename Fn>
+class indexView;
+
+//! \brief A lazy linspace: the samples are generated on access, nothing is stored.
+template <typename T>
+auto linspace_view(T start, T stop, size_t num = 50, bool endpoint = true);
+
+//! \brief A lazy geomspace, \see linspace_view.
+template <typename T>
+auto geomspace_view(T start, T stop, size_t num = 50, bool endpoint = true);
+
+//! \brief A lazy logspace, \see linspace_view.
+template <typename T>
+auto logspace_view(T start, T stop, size_t num, bool endpoint = true, double base = 10.0);
+
 ///@}
 
 //! \name Progressions & Sums
@@ -71,70 +107,255 @@ template <typename T>
 double geom_sum(T n, T a1, T d);
 ///@}
 
+//! \name Array kernels
+//! Vectorized with SSE2, AVX2 (with FMA) or AVX-512, as supported by the CPU at runtime; the choice is made once.
+//! The reductions' rounding thus depends on the instruction set, within the bounds of their error.
+///@{
+
+//! \brief The instruction sets of the array kernels.
+enum class simdLevel
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+//! \brief The instruction set used by the array kernels on this CPU.
+simdLevel simd_level() noexcept;
+
+//! \brief The pairwise sum of \p x[0, n), the error grows as \f$\mathcal{O}(\log n)\f$.
+double pairwise_sum(const double * x, size_t n) noexcept;
+
+//! \brief The compensated (Kahan) sum of \p x[0, n), the error is independent of \p n.
+double kahan_sum(const double * x, size_t n) noexcept;
+
+//! \brief The dot product of \p x[0, n) & \p y[0, n).
+double dot(const double * x, const double * y, size_t n) noexcept;
+
+//! \brief \p y[i] += \p a * \p x[i] for i in [0, n).
+void axpy(double a, const double * x, double * y, size_t n) noexcept;
+
+//! \brief The discounted expectation \p out[i] = \p a * \p x[i] + \p b * \p x[i + 1] for i in [0, n),
+//! i.e. a step of the backward induction on a binomial tree.
+//! \param x: n + 1 values
+//! \param out: n values, may be the same as \p x for an in-place induction
+void discounted_expectation(double a, double b, const double * x, double * out, size_t n) noexcept;
+///@}
+
+//! \name Integer arithmetic
+///@{
+
+//! \brief The integer square root, i.e. \f$\lfloor \sqrt{n} \rfloor\f$, exact for the whole range of \p T.
+//! Usable in constant expressions.
+//! \param n
+template <typename T>
+constexpr T isqrt(T n);
+///@}
+
+template <typename Fn>
+class indexView
+{
+public:
+    using value_type = decltype(std::declval<const Fn &>()(size_t{}));
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = indexView::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        iterator() = default;
+        iterator(const Fn * p_fn, size_t p_index) : m_fn(p_fn), m_index(p_index) {}
+
+        value_type operator*() const { return (*m_fn)(m_index); }
+        value_type operator[](difference_type n) const { return (*m_fn)(m_index + n); }
+
+        iterator & operator++() { ++m_index; return *this; }
+        iterator operator++(int) { return {m_fn, m_index++}; }
+        iterator & operator--() { --m_index; return *this; }
+        iterator operator--(int) { return {m_fn, m_index--}; }
+        iterator & operator+=(difference_type n) { m_index += n; return *this; }
+        iterator & operator-=(difference_type n) { m_index -= n; return *this; }
+        iterator operator+(difference_type n) const { return {m_fn, m_index + n}; }
+        friend iterator operator+(difference_type n, const iterator & it) { return it + n; }
+        iterator operator-(difference_type n) const { return {m_fn, m_index - n}; }
+        difference_type operator-(const iterator & other) const
+        {
+            return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+        }
+
+        bool operator==(const iterator & other) const { return m_index == other.m_index; }
+        bool operator!=(const iterator & other) const { return m_index != other.m_index; }
+        bool operator<(const iterator & other) const { return m_index < other.m_index; }
+        bool operator>(const iterator & other) const { return m_index > other.m_index; }
+        bool operator<=(const iterator & other) const { return m_index <= other.m_index; }
+        bool operator>=(const iterator & other) const { return m_index >= other.m_index; }
+
+    private:
+        const Fn * m_fn{nullptr};
+        size_t m_index{0};
+    };
+
+    indexView(Fn p_fn, size_t p_num) : m_fn(std::move(p_fn)), m_num(p_num) {}
+
+    value_type operator[](size_t i) const { return m_fn(i); }
+    size_t size() const noexcept { return m_num; }
+    bool empty() const noexcept { return m_num == 0; }
+
+    //! NOTE: the iterators refer to the view, which has to outlive them
+    iterator begin() const { return {&m_fn, 0}; }
+    iterator end() const { return {&m_fn, m_num}; }
+
+private:
+    Fn m_fn;
+    size_t m_num;
+};
+
+
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //  IMPLEMENTATION
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace detail
+{
+
+// the samples as functions of the index; interior() is branch-free for the vectorizable loops,
+// operator() makes the endpoint exact
 template <typename T>
-std::vector<T> linspace(T start, T stop, size_t num, bool endpoint)
+struct linspaceFn
 {
-    std::vector<T> ret(num);
-    double diff = stop - start;
-    // add the endpoint
-    if (endpoint)
+    linspaceFn(T p_start, T p_stop, size_t p_num, bool p_endpoint)
+        : start(p_start), stop(p_stop), last(p_endpoint && p_num > 1 ? p_num - 1 : p_num),
+          step(last == 0 ? 0.0 : static_cast<double>(p_stop - p_start) / last)
     {
-        diff *= static_cast<double>(num) / (num - 1);
     }
 
-    for (size_t i = 0; i < num; ++i)
+    T interior(size_t i) const { return start + static_cast<T>(step * i); }
+    T operator()(size_t i) const { return i == last ? stop : interior(i); }
+
+    T start;
+    T stop;
+    // the index of the endpoint; never reached unless it's included
+    size_t last;
+    double step;
+};
+
+template <typename T>
+struct geomspaceFn
+{
+    geomspaceFn(T p_start, T p_stop, size_t p_num, bool p_endpoint)
+        : start(p_start), stop(p_stop), last(p_endpoint && p_num > 1 ? p_num - 1 : p_num),
+          logStep(last == 0 ? 0.0 : std::log(static_cast<double>(p_stop) / p_start) / last)
     {
-        ret[i] = start + static_cast<T>((diff / num) * i);
     }
 
-    return ret;
-}
+    T interior(size_t i) const { return static_cast<T>(start * std::exp(logStep * i)); }
+    T operator()(size_t i) const { return i == last ? stop : interior(i); }
+
+    T start;
+    T stop;
+    size_t last;
+    double logStep;
+};
 
 template <typename T>
-std::vector<T> geomspace(T start, T stop, size_t num, bool endpoint)
+struct logspaceFn
 {
-    std::vector<T> ret(num);
-    size_t n = endpoint ? (num - 1) : num;
-    double diff = std::pow(stop / start, 1.0 / n);
-
-    ret[0] = start;
-    double ans = start;
-    for (size_t i = 1; i < num - 1; ++i)
+    logspaceFn(T p_start, T p_stop, size_t p_num, bool p_endpoint, double p_base)
+        : powers(p_start, p_stop, p_num, p_endpoint), last(powers.last), base(p_base)
     {
-        ans = (ans * diff);
-        ret[i] = static_cast<T>(ans);
     }
 
-    // round-off can floor the endpoint which we want exact
-    ans = (ans * diff);
-    if (endpoint)
+    T interior(size_t i) const { return static_cast<T>(std::pow(base, powers.interior(i))); }
+    T operator()(size_t i) const { return static_cast<T>(std::pow(base, powers(i))); }
+
+    linspaceFn<T> powers;
+    size_t last;
+    double base;
+};
+
+template <typename Fn, typename OutputIt>
+OutputIt generate(const Fn & fn, size_t num, OutputIt out)
+{
+    // the endpoint, if included, separately
+    size_t interior = std::min(fn.last, num);
+    for (size_t i = 0; i < interior; ++i, ++out)
     {
-        if (std::abs(ans - stop) > 1E-6)
-        {
-            throw std::range_error("Endpoint not connecting to the series calculated!");
-        }
-        ret[num - 1] = stop;
+        *out = fn.interior(i);
     }
-    else
+    for (size_t i = interior; i < num; ++i, ++out)
     {
-        ret[num - 1] = static_cast<T>(ans);
+        *out = fn(i);
     }
+    return out;
+}
+
+} // namespace detail
+
+template <typename T>
+std::vector<T> linspace(T start, T stop, size_t num, bool endpoint)
+{
+    std::vector<T> ret(num);
+    linspace_into(ret.data(), start, stop, num, endpoint);
+    return ret;
+}
 
+template <typename T>
+std::vector<T> geomspace(T start, T stop, size_t num, bool endpoint)
+{
+    std::vector<T> ret(num);
+    geomspace_into(ret.data(), start, stop, num, endpoint);
     return ret;
 }
 
 template <typename T>
 std::vector<T> logspace(T start, T stop, size_t num, bool endpoint, double base)
 {
-    auto powers = linspace(start, stop, num, endpoint);
     std::vector<T> ret(num);
-    std::transform(powers.begin(), powers.end(), ret.begin(), [base](auto power) { return std::pow(base, power); });
+    logspace_into(ret.data(), start, stop, num, endpoint, base);
     return ret;
 }
 
+template <typename T, typename OutputIt>
+OutputIt linspace_into(OutputIt out, T start, T stop, size_t num, bool endpoint)
+{
+    return detail::generate(detail::linspaceFn<T>(start, stop, num, endpoint), num, out);
+}
+
+template <typename T, typename OutputIt>
+OutputIt geomspace_into(OutputIt out, T start, T stop, size_t num, bool endpoint)
+{
+    return detail::generate(detail::geomspaceFn<T>(start, stop, num, endpoint), num, out);
+}
+
+template <typename T, typename OutputIt>
+OutputIt logspace_into(OutputIt out, T start, T stop, size_t num, bool endpoint, double base)
+{
+    return detail::generate(detail::logspaceFn<T>(start, stop, num, endpoint, base), num, out);
+}
+
+template <typename T>
+auto linspace_view(T start, T stop, size_t num, bool endpoint)
+{
+    return indexView(detail::linspaceFn<T>(start, stop, num, endpoint), num);
+}
+
+template <typename T>
+auto geomspace_view(T start, T stop, size_t num, bool endpoint)
+{
+    return indexView(detail::geomspaceFn<T>(start, stop, num, endpoint), num);
+}
+
+template <typename T>
+auto logspace_view(T start, T stop, size_t num, bool endpoint, double base)
+{
+    return indexView(detail::logspaceFn<T>(start, stop, num, endpoint, base), num);
+}
+
 template <typename T>
 T arithm_sum(T n, T a1, T d)
 {
@@ -147,5 +368,35 @@ double geom_sum(T n, T a1, T d)
     return static_cast<double>(std::round(a1 * (1.0 - std::pow(d, n)) / (1.0 - d)));
 }
 
+template <typename T>
+constexpr T isqrt(T n)
+{
+    static_assert(std::is_unsigned_v<T>, "isqrt requires an unsigned integer type");
+
+    // digit-by-digit, two bits at a time
+    T root = 0;
+    T bit = T{1} << (std::numeric_limits<T>::digits - 2);
+    while (bit > n)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (n >= root + bit)
+        {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
 } // namespace cm
 #endif // NUMERIC_H
@@ -0,0 +1,106 @@
+/** \file parallelfunctional.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * The folds of functional.h run on a ThreadPool.
+ */
+
+#ifndef CM_PARALLELFUNCTIONAL_H
+#define CM_PARALLELFUNCTIONAL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <common/functional.h>
+#include <common/thread.h>
+
+namespace cm
+{
+
+//! \brief A moving_accumulate run on a thread pool: the range is split in chunks that are folded concurrently,
+//! the partial results are then combined in a tree.
+//! Each chunk is folded as in pairwise_accumulate. The chunks & the order of the combination don't depend on the scheduling,
+//! so the results are reproducible.
+//! Each chunk starts from \p identity; \p combine has to be associative with \p identity as its neutral element,
+//! but needn't be commutative.
+//! \param pool the pool to run on, the calling thread participates
+//! \param first iterator to first element
+//! \param last  iterator to last element
+//! \param init  initial value, combined with the total
+//! \param folding_function (T, element) -> T, called concurrently
+//! \param combine (T, T) -> T, joins two partial results
+//! \param chunk_size the number of elements per task, 0 for a few chunks per thread
+//! \param block_size the number of elements folded sequentially within a chunk, \see pairwise_accumulate
+//! \param identity the neutral element of \p combine, the start of each chunk
+//! \return the accumulated values
+template <typename It, typename T, typename F, typename C>
+T parallel_accumulate(ThreadPool & pool, It first, It last, T init, F folding_function, C combine, size_t chunk_size = 0,
+                      size_t block_size = 128, T identity = T{});
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace detail
+{
+
+// combines the partial results in [first, last) in a balanced tree
+template <typename T, typename C>
+T pairwiseCombine(std::vector<std::optional<T>> & parts, size_t first, size_t last, C & combine)
+{
+    if (last - first == 1)
+    {
+        return std::move(*parts[first]);
+    }
+
+    size_t mid = first + (last - first) / 2;
+    T left = pairwiseCombine(parts, first, mid, combine);
+    T right = pairwiseCombine(parts, mid, last, combine);
+
+    return combine(std::move(left), std::move(right));
+}
+
+} // namespace detail
+
+template <typename It, typename T, typename F, typename C>
+T parallel_accumulate(ThreadPool & pool, It first, It last, T init, F folding_function, C combine, size_t chunk_size,
+                      size_t block_size, T identity)
+{
+    auto distance = std::distance(first, last);
+    if (distance <= 0)
+    {
+        return init;
+    }
+
+    const size_t n = static_cast<size_t>(distance);
+    if (chunk_size == 0)
+    {
+        chunk_size = std::max<size_t>(1, n / (4 * (pool.size() + 1)));
+    }
+    const size_t numChunks = (n + chunk_size - 1) / chunk_size;
+    block_size = std::max<size_t>(block_size, 1);
+
+    std::vector<std::optional<T>> parts(numChunks);
+    pool.parallel_for<size_t>(
+        0, numChunks,
+        [&](size_t i) {
+            // each chunk pairwise as well
+            It chunkFirst = std::next(first, static_cast<std::ptrdiff_t>(i * chunk_size));
+            size_t chunkSize = std::min(chunk_size, n - i * chunk_size);
+            parts[i].emplace(detail::pairwiseFold<It, T>(chunkFirst, chunkSize, folding_function, combine, block_size, identity));
+        },
+        1);
+
+    T total = detail::pairwiseCombine(parts, 0, numChunks, combine);
+    return combine(std::move(init), std::move(total));
+}
+
+} // namespace cm
+
+#endif // CM_PARALLELFUNCTIONAL_H
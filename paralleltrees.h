@@ -0,0 +1,166 @@
+/** \file paralleltrees.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Multithreaded algorithms on the array-based trees.
+ */
+
+#ifndef CM_PARALLELTREES_H
+#define CM_PARALLELTREES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <common/thread.h>
+#include <common/trees.h>
+
+namespace cm
+{
+
+//! \brief Backward induction with each level split into contiguous per-thread chunks.
+//! The threads synchronize on a FlexBarrier between the levels. As the levels get narrower towards the root,
+//! the barrier's completion step shrinks the number of participating threads so that no chunk falls below \p minChunk nodes;
+//! the surplus threads then finish. The calling thread participates as well.
+//! \param tree: a tree with contiguous levels, i.e. recombinantBTree, recombinantTTree, staticTree or rollingRecombinantBTree.
+//!  The leaves have to be populated beforehand.
+//! \param kernel: a callable with the signature void (levelSpan<Node>), \see recombinantBTree::backwardInduction.
+//!  It is invoked concurrently on disjoint spans of the same level, so it must be safe to call from multiple threads
+//!  & must not throw.
+//! \param nThreads: the maximum number of participating threads, 0 for std::thread::hardware_concurrency()
+//! \param minChunk: the minimum number of nodes on a level per thread
+template <typename Tree, typename Kernel>
+void parallelBackwardInduction(Tree & tree, Kernel && kernel, unsigned nThreads = 0, size_t minChunk = 1024);
+
+//! \brief Backward induction on the workers of a thread pool, as a team of at most pool.size() + 1 threads.
+//! Only the workers idle at the call join the team, \see ThreadPool::reserveTeam; safe to call from a pool task.
+//! \see parallelBackwardInduction above.
+template <typename Tree, typename Kernel>
+void parallelBackwardInduction(ThreadPool & pool, Tree & tree, Kernel && kernel, size_t minChunk = 1024);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace detail
+{
+
+// trees that keep only a window of levels in memory, i.e. rollingRecombinantBTree
+template <typename Tree, typename = void>
+struct hasWindow : std::false_type
+{};
+
+template <typename Tree>
+struct hasWindow<Tree, std::void_t<decltype(std::declval<Tree &>().setWindow(size_t{}))>> : std::true_type
+{};
+
+// the induction proper, \p launch(n, work) runs work(id) for all ids in [0, n) concurrently
+template <typename Tree, typename Kernel, typename Launch>
+void backwardInductionTeam(Tree & tree, Kernel && kernel, unsigned nThreads, size_t minChunk, Launch && launch)
+{
+    using Node = typename Tree::value_type;
+
+    if (tree.numLevels() < 2)
+    {
+        return;
+    }
+    CM_PROFILE_SCOPE("parallelBackwardInduction");
+
+    minChunk = std::max<size_t>(minChunk, 1);
+
+    auto levelSize = [&tree](size_t l) { return tree.right_boundary(l) - tree.left_boundary(l) + 1; };
+    // a pure function of the level, so every thread can work out by itself whether it still participates
+    auto activeThreads = [&levelSize, nThreads, minChunk](size_t l) {
+        return static_cast<unsigned>(std::clamp<size_t>(levelSize(l) / minChunk, 1, nThreads));
+    };
+    auto setWindow = [&tree](size_t l) {
+        if constexpr (detail::hasWindow<Tree>::value)
+        {
+            tree.setWindow(l);
+        }
+    };
+
+    const size_t top = tree.numLevels() - 2;
+    setWindow(top);
+
+    // invoked once per level on the last thread to arrive, before the others are released
+    size_t barrierLevel = top;
+    BasicFlexBarrier barrier(activeThreads(top), [&barrierLevel, &activeThreads, &setWindow]() -> std::ptrdiff_t {
+        --barrierLevel;
+        setWindow(barrierLevel);
+        return activeThreads(barrierLevel);
+    });
+
+    auto work = [&](unsigned id) {
+        for (size_t l = top;; --l)
+        {
+            unsigned active = activeThreads(l);
+            if (id >= active)
+            {
+                // already discounted by the completion step
+                return;
+            }
+
+            size_t size = levelSize(l);
+            size_t first = size * id / active;
+            size_t last = size * (id + 1) / active;
+            Node * current = tree.levelData(l);
+            const Node * next = tree.levelData(l + 1);
+
+            kernel(levelSpan<Node>{l, first, last - first, current + first, next + first});
+
+            if (l == 0)
+            {
+                return;
+            }
+            barrier.arrive_and_wait();
+        }
+    };
+
+    launch(activeThreads(top), work);
+}
+
+} // namespace detail
+
+template <typename Tree, typename Kernel>
+void parallelBackwardInduction(Tree & tree, Kernel && kernel, unsigned nThreads, size_t minChunk)
+{
+    if (nThreads == 0)
+    {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    detail::backwardInductionTeam(tree, kernel, nThreads, minChunk, [](unsigned n, auto & work) {
+        std::vector<std::thread> threads;
+        threads.reserve(n - 1);
+        for (unsigned id = 1; id < n; ++id)
+        {
+            threads.emplace_back(work, id);
+        }
+
+        work(0);
+
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+    });
+}
+
+template <typename Tree, typename Kernel>
+void parallelBackwardInduction(ThreadPool & pool, Tree & tree, Kernel && kernel, size_t minChunk)
+{
+    // the barrier is sized for the workers actually reserved
+    ThreadPool::team members = pool.reserveTeam(pool.size() + 1);
+    detail::backwardInductionTeam(tree, kernel, members.size(), minChunk,
+                                  [&members](unsigned n, auto & work) { members.run(n, work); });
+}
+
+} // namespace cm
+
+#endif // CM_PARALLELTREES_H
@@ -9,12 +9,20 @@
 #ifndef PATTERNS_H
 #define PATTERNS_H
 
-#include <map>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
 #include <memory>
-#include <iostream>
+#include <new>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "functional.h"
+#include "tools.h"
 
 namespace cm
 {
@@ -43,8 +51,16 @@ protected:
 };
 
 
+//! \brief The deleter of the objects created in an arena: only destroys the object, the arena owns the memory.
+template <class Base>
+struct arenaDeleter
+{
+    void operator()(Base * p_ptr) const noexcept { p_ptr->~Base(); }
+};
+
 // Initially developed as part of the Derivatives project.
 //! \brief A Generic factory class for a hierarchy of classes with \p Base as the top-level base class.
+//! The methods are looked up by name in a hash table, or directly by the handle obtained on registration or via find().
 template <class Base>
 class Factory : public Singleton<Factory<Base>>
 {
@@ -54,26 +70,106 @@ public:
     template <typename... Args>
     using FactoryMethod = Ret (*)(Args...);
 
+    //! \brief An object created in an arena, destroyed with the pointer; \see create_in.
+    using ArenaRet = std::unique_ptr<Base, arenaDeleter<Base>>;
+
+    //! \brief Constructs the class in the given storage.
+    template <typename... Args>
+    using PlacementMethod = Base * (*)(void *, Args...);
+
+    //! \brief A pre-resolved factory method.
+    using handle = size_t;
+    //! \brief The handle of no factory method.
+    static constexpr handle npos = static_cast<handle>(-1);
+
     //! \brief Registers a factory method \p p_factory for a class under \p p_name.
+    //! Registering under an existing name replaces the method, the handle remains the same.
     //! \param p_name
     //! \param p_factory
+    //! \return The handle of the method.
+    template <typename... Args>
+    handle registerFactoryMethod(std::string p_name, FactoryMethod<Args...> p_factory);
+
+    //! \brief Registers a placement method for a class under \p p_name, enabling create_in & create_n for it.
+    //! \param p_name
+    //! \param p_construct
+    //! \param p_size: sizeof the class
+    //! \param p_align: alignof the class
+    //! \return The handle of the method, shared with the factory method of the same name.
     template <typename... Args>
-    void registerFactoryMethod(std::string p_name, FactoryMethod<Args...> p_factory);
+    handle registerPlacementMethod(std::string p_name, PlacementMethod<Args...> p_construct, size_t p_size, size_t p_align);
+
+    //! \brief Resolves the method registered under \p p_name.
+    //! \return Its handle, or npos if \p p_name not registered.
+    handle find(std::string_view p_name) const noexcept;
 
     //! \brief Creates a pointer to the \p Base class via the method stored under \p p_name.
     //! \param p_name
     //! \param p_args: constructor parameters.
     //! \return A std::unique_ptr to the \p Base class of the class requested,
     //!  or a nullptr if \p p_name not registered.
+    //!  Throws std::bad_function_call if \p p_args don't match the registered method's parameters.
+    template <typename... Args>
+    Ret create(std::string_view p_name, Args... p_args);
+
+    //! \brief Creates a pointer to the \p Base class via the method with the handle \p p_handle.
+    //! \return As above, a nullptr if \p p_handle is not a valid handle.
     template <typename... Args>
-    Ret create(const std::string & p_name, Args... p_args);
+    Ret create(handle p_handle, Args... p_args);
+
+    //! @name Arena creation
+    //! The objects are constructed in the memory of \p p_arena, anything with a
+    //! void * allocate(size_t bytes, size_t align), e.g. monotonicArena. They have to be destroyed before the arena
+    //! releases the memory.
+    ///@{
+    //! \brief Creates an object in \p p_arena via the placement method stored under \p p_name.
+    //! \return As create, a nullptr if no placement method registered under \p p_name.
+    template <typename Arena, typename... Args>
+    ArenaRet create_in(Arena & p_arena, std::string_view p_name, Args... p_args);
+
+    template <typename Arena, typename... Args>
+    ArenaRet create_in(Arena & p_arena, handle p_handle, Args... p_args);
+
+    //! \brief Creates an object for each element of \p p_args, contiguously in a single allocation in \p p_arena.
+    //! The method is resolved & its signature checked once for the whole range.
+    //! \param p_args: a range of std::tuples of the constructor parameters.
+    //! \return The objects in the order of \p p_args, empty if no placement method registered under \p p_name.
+    //!  Throws std::bad_function_call if the tuples don't match the registered method's parameters.
+    template <typename Arena, typename Range>
+    std::vector<ArenaRet> create_n(Arena & p_arena, std::string_view p_name, const Range & p_args);
+
+    template <typename Arena, typename Range>
+    std::vector<ArenaRet> create_n(Arena & p_arena, handle p_handle, const Range & p_args);
+    ///@}
 
 protected:
     friend class Singleton<Factory<Base>>;
     Factory() = default;
 
 private:
-    std::map<std::string, AnyCallable<Ret>> m_registeredFactories{};
+    struct method
+    {
+        SmallCallable<Ret> m_create;
+        SmallCallable<Base *> m_construct;
+        size_t m_size{0};
+        size_t m_align{0};
+    };
+
+    // the method registered under p_name, added if new
+    method & entry(std::string p_name, handle & p_handle);
+    // the placement method under p_handle, nullptr if none
+    const method * placement(handle p_handle) const noexcept;
+
+    template <typename... Ts>
+    static auto bindTuple(const SmallCallable<Base *> & p_construct, const std::tuple<Ts...> *)
+    {
+        return p_construct.template bind<void *, Ts...>();
+    }
+
+    // stable storage for the keys of the index
+    std::deque<std::string> m_names{};
+    std::unordered_map<std::string_view, handle> m_index{};
+    std::vector<method> m_registeredFactories{};
 };
 
 //! \brief An adapter that makes any class usable with the generic Factory.
@@ -89,6 +185,7 @@ public:
     factoryRegisterer(std::string p_name);
 
     static std::unique_ptr<Base> create(Args... p_args);
+    static Base * construct(void * p_storage, Args... p_args);
 };
 
 //!@}
@@ -115,25 +212,153 @@ T & Singleton<T>::instance()
 
 template <class Base>
 template <typename... Args>
-void Factory<Base>::registerFactoryMethod(std::string p_name, FactoryMethod<Args...> p_factory)
+typename Factory<Base>::handle Factory<Base>::registerFactoryMethod(std::string p_name, FactoryMethod<Args...> p_factory)
+{
+    // the signature is recorded here, a create with mismatching arguments fails with std::bad_function_call
+    handle ret;
+    entry(std::move(p_name), ret).m_create = cm::SmallCallable<Ret>(p_factory);
+    return ret;
+}
+
+template <class Base>
+template <typename... Args>
+typename Factory<Base>::handle Factory<Base>::registerPlacementMethod(std::string p_name, PlacementMethod<Args...> p_construct,
+                                                                      size_t p_size, size_t p_align)
+{
+    handle ret;
+    method & current = entry(std::move(p_name), ret);
+    current.m_construct = cm::SmallCallable<Base *>(p_construct);
+    current.m_size = p_size;
+    current.m_align = p_align;
+    return ret;
+}
+
+template <class Base>
+typename Factory<Base>::method & Factory<Base>::entry(std::string p_name, handle & p_handle)
+{
+    p_handle = find(p_name);
+    if (p_handle != npos)
+    {
+        return m_registeredFactories[p_handle];
+    }
+
+    p_handle = m_registeredFactories.size();
+    m_registeredFactories.emplace_back();
+    m_names.push_back(std::move(p_name));
+    m_index.emplace(m_names.back(), p_handle);
+
+    return m_registeredFactories.back();
+}
+
+template <class Base>
+const typename Factory<Base>::method * Factory<Base>::placement(handle p_handle) const noexcept
+{
+    if (p_handle >= m_registeredFactories.size() || !m_registeredFactories[p_handle].m_construct)
+    {
+        return nullptr;
+    }
+    return &m_registeredFactories[p_handle];
+}
+
+template <class Base>
+typename Factory<Base>::handle Factory<Base>::find(std::string_view p_name) const noexcept
+{
+    auto it = m_index.find(p_name);
+    return it == m_index.end() ? npos : it->second;
+}
+
+template <class Base>
+template <typename... Args>
+typename Factory<Base>::Ret Factory<Base>::create(std::string_view p_name, Args... p_args)
 {
-    //    m_registeredFactories[p_name] = cm::AnyCallable<Ret>(std::forward<FactoryMethod<Args...>>(p_factory));
-    m_registeredFactories[std::move(p_name)] = cm::AnyCallable<Ret>(std::move(p_factory));
+    return create(find(p_name), std::forward<Args>(p_args)...);
 }
 
 template <class Base>
 template <typename... Args>
-typename Factory<Base>::Ret Factory<Base>::create(const std::string & p_name, Args... p_args)
+typename Factory<Base>::Ret Factory<Base>::create(handle p_handle, Args... p_args)
 {
-    try
+    CM_PROFILE_TIMER("Factory::create");
+    if (p_handle >= m_registeredFactories.size() || !m_registeredFactories[p_handle].m_create)
     {
-        return m_registeredFactories.at(p_name)(std::forward<Args>(p_args)...);
+        CM_PROFILE_COUNT("Factory::create miss", 1);
+        return nullptr;
     }
-    catch (const std::out_of_range &)
+    CM_PROFILE_COUNT("Factory::create hit", 1);
+    return m_registeredFactories[p_handle].m_create(std::forward<Args>(p_args)...);
+}
+
+template <class Base>
+template <typename Arena, typename... Args>
+typename Factory<Base>::ArenaRet Factory<Base>::create_in(Arena & p_arena, std::string_view p_name, Args... p_args)
+{
+    return create_in(p_arena, find(p_name), std::forward<Args>(p_args)...);
+}
+
+template <class Base>
+template <typename Arena, typename... Args>
+typename Factory<Base>::ArenaRet Factory<Base>::create_in(Arena & p_arena, handle p_handle, Args... p_args)
+{
+    const method * current = placement(p_handle);
+    if (!current)
     {
-        std::cerr << "cm::Factory::create: No function registered as " << p_name << "\n";
         return nullptr;
     }
+
+    if (!current->m_construct.template accepts<void *, Args...>())
+    {
+        throw std::bad_function_call();
+    }
+
+    void * storage = p_arena.allocate(current->m_size, current->m_align);
+    Base * ret = current->m_construct.template call_unchecked<void *, Args...>(std::move(storage), std::forward<Args>(p_args)...);
+    return ArenaRet(ret);
+}
+
+template <class Base>
+template <typename Arena, typename Range>
+std::vector<typename Factory<Base>::ArenaRet> Factory<Base>::create_n(Arena & p_arena, std::string_view p_name,
+                                                                      const Range & p_args)
+{
+    return create_n(p_arena, find(p_name), p_args);
+}
+
+template <class Base>
+template <typename Arena, typename Range>
+std::vector<typename Factory<Base>::ArenaRet> Factory<Base>::create_n(Arena & p_arena, handle p_handle, const Range & p_args)
+{
+    std::vector<ArenaRet> ret;
+
+    const method * current = placement(p_handle);
+    if (!current)
+    {
+        return ret;
+    }
+
+    using Tuple = std::decay_t<decltype(*std::begin(p_args))>;
+    auto construct = bindTuple(current->m_construct, static_cast<const Tuple *>(nullptr));
+    if (!construct)
+    {
+        throw std::bad_function_call();
+    }
+
+    const size_t n = static_cast<size_t>(std::distance(std::begin(p_args), std::end(p_args)));
+    if (n == 0)
+    {
+        return ret;
+    }
+
+    // sizeof is a multiple of alignof, so the objects are contiguous
+    auto * storage = static_cast<std::byte *>(p_arena.allocate(current->m_size * n, current->m_align));
+    ret.reserve(n);
+
+    for (const auto & args : p_args)
+    {
+        std::apply([&](const auto &... p_ctorArgs) { ret.emplace_back(construct(storage, p_ctorArgs...)); }, args);
+        storage += current->m_size;
+    }
+
+    return ret;
 }
 
 
@@ -144,8 +369,10 @@ template <class T, class Base, typename... Args>
 factoryRegisterer<T, Base, Args ...>::factoryRegisterer(std::string p_name)
 {
     // this should fail @compile-time if no matching constructor
-    Factory<Base>::instance().registerFactoryMethod(std::move(p_name),
+    Factory<Base>::instance().registerFactoryMethod(p_name,
         &factoryRegisterer<T, Base, Args...>::create);
+    Factory<Base>::instance().registerPlacementMethod(std::move(p_name), &factoryRegisterer<T, Base, Args...>::construct,
+                                                      sizeof(T), alignof(T));
 }
 
 template <class T, class Base, typename... Args>
@@ -154,5 +381,11 @@ std::unique_ptr<Base> factoryRegisterer<T, Base, Args...>::create(Args... p_args
     return std::make_unique<T>(std::forward<Args>(p_args)...);
 }
 
+template <class T, class Base, typename... Args>
+Base * factoryRegisterer<T, Base, Args...>::construct(void * p_storage, Args... p_args)
+{
+    return ::new (p_storage) T(std::forward<Args>(p_args)...);
+}
+
 } // namespace cm
 #endif // PATTERNS_H
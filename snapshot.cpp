@@ -0,0 +1,175 @@
+/** \file snapshot.cpp
+ * \author Andrej Leban
+ * \date 10/2026
+ */
+
+#include "snapshot.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CM_SNAPSHOT_MMAP
+#endif
+
+namespace cm
+{
+
+std::uint64_t snapshotChecksum(const void * p_data, size_t p_bytes) noexcept
+{
+    constexpr std::uint64_t prime = 0x100000001b3ULL;
+    std::uint64_t ret = 0xcbf29ce484222325ULL;
+
+    const auto * data = static_cast<const unsigned char *>(p_data);
+    size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= p_bytes; i += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        ret = (ret ^ word) * prime;
+    }
+    for (; i < p_bytes; ++i)
+    {
+        ret = (ret ^ data[i]) * prime;
+    }
+
+    return ret;
+}
+
+void detail::writeSnapshot(const std::string & p_path, const snapshotHeader & p_header, const void * p_data)
+{
+    std::ofstream file(p_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&p_header), sizeof(p_header));
+    file.write(static_cast<const char *>(p_data), static_cast<std::streamsize>(p_header.count * p_header.nodeSize));
+    file.close();
+    if (!file)
+    {
+        throw std::range_error("saveSnapshot: cannot write " + p_path);
+    }
+}
+
+
+// mappedSnapshot
+
+mappedSnapshot::mappedSnapshot(const std::string & p_path, snapshotMode p_mode, bool p_verify) : m_mode(p_mode)
+{
+#ifdef CM_SNAPSHOT_MMAP
+    int fd = ::open(p_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::range_error("mappedSnapshot: cannot open " + p_path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(snapshotHeader))
+    {
+        ::close(fd);
+        throw std::range_error("mappedSnapshot: not a snapshot: " + p_path);
+    }
+    m_size = static_cast<size_t>(st.st_size);
+
+    // a private mapping of a read-only descriptor can still be written to, copy-on-write
+    int prot = p_mode == snapshotMode::readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags = p_mode == snapshotMode::readOnly ? MAP_SHARED : MAP_PRIVATE;
+    void * base = ::mmap(nullptr, m_size, prot, flags, fd, 0);
+    // the mapping keeps the file referenced
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        throw std::range_error("mappedSnapshot: cannot map " + p_path);
+    }
+    m_base = base;
+#else
+    std::ifstream file(p_path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        throw std::range_error("mappedSnapshot: cannot open " + p_path);
+    }
+    m_size = static_cast<size_t>(file.tellg());
+    if (m_size < sizeof(snapshotHeader))
+    {
+        throw std::range_error("mappedSnapshot: not a snapshot: " + p_path);
+    }
+
+    // no mmap, so the file is read into an aligned buffer instead
+    m_base = std::aligned_alloc(sizeof(snapshotHeader), (m_size + sizeof(snapshotHeader) - 1) & ~(sizeof(snapshotHeader) - 1));
+    if (!m_base)
+    {
+        throw std::bad_alloc();
+    }
+    file.seekg(0);
+    file.read(static_cast<char *>(m_base), static_cast<std::streamsize>(m_size));
+#endif
+
+    const snapshotHeader & head = header();
+    const char * error = nullptr;
+    if (std::memcmp(head.magic, snapshotHeader::magicValue, sizeof(head.magic)) != 0 || head.nodeSize == 0
+        || (m_size - sizeof(snapshotHeader)) / head.nodeSize < head.count)
+    {
+        error = "mappedSnapshot: not a snapshot or truncated: ";
+    }
+    else if (p_verify && snapshotChecksum(data(), head.count * head.nodeSize) != head.checksum)
+    {
+        error = "mappedSnapshot: checksum mismatch: ";
+    }
+
+    if (error)
+    {
+        unmap();
+        throw std::range_error(error + p_path);
+    }
+}
+
+mappedSnapshot::~mappedSnapshot()
+{
+    unmap();
+}
+
+void mappedSnapshot::unmap() noexcept
+{
+    if (!m_base)
+    {
+        return;
+    }
+
+#ifdef CM_SNAPSHOT_MMAP
+    ::munmap(m_base, m_size);
+#else
+    std::free(m_base);
+#endif
+    m_base = nullptr;
+}
+
+const snapshotHeader & mappedSnapshot::header() const noexcept
+{
+    return *static_cast<const snapshotHeader *>(m_base);
+}
+
+snapshotMode mappedSnapshot::mode() const noexcept
+{
+    return m_mode;
+}
+
+void * mappedSnapshot::data() const noexcept
+{
+    return static_cast<char *>(m_base) + sizeof(snapshotHeader);
+}
+
+void * mappedSnapshot::claim(size_t p_bytes) noexcept
+{
+    const snapshotHeader & head = header();
+    if (m_claimed || p_bytes != head.count * head.nodeSize)
+    {
+        return nullptr;
+    }
+
+    m_claimed = true;
+    return data();
+}
+
+} // namespace cm
@@ -0,0 +1,273 @@
+/** \file snapshot.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Persistent tree snapshots, mapped back into memory without deserialization.
+ */
+
+#ifndef CM_SNAPSHOT_H
+#define CM_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <common/trees.h>
+
+namespace cm
+{
+
+//! \brief The geometry of a snapshotted tree.
+enum class treeGeometry : std::uint32_t
+{
+    //! \brief A complete binary tree, i.e. any other subclass of bTree.
+    binary = 0,
+    recombinantB = 1,
+    recombinantT = 2
+};
+
+//! \brief The header of a snapshot file, followed by the raw node array.
+//! 64 bytes, so that the mapped nodes are aligned to a cache line.
+struct snapshotHeader
+{
+    static constexpr char magicValue[8] = {'c', 'm', 't', 'r', 'e', 'e', 's', '1'};
+
+    char magic[8];
+    //! \brief A treeGeometry.
+    std::uint32_t geometry;
+    //! \brief sizeof the Node.
+    std::uint32_t nodeSize;
+    std::uint64_t depth;
+    //! \brief The number of nodes.
+    std::uint64_t count;
+    //! \brief snapshotChecksum of the node array.
+    std::uint64_t checksum;
+    std::uint64_t reserved[3];
+};
+static_assert(sizeof(snapshotHeader) == 64, "the snapshot header must keep the nodes cache line aligned");
+
+//! \brief A fast 64-bit checksum (FNV-1a over 8-byte words) of \p p_bytes at \p p_data.
+std::uint64_t snapshotChecksum(const void * p_data, size_t p_bytes) noexcept;
+
+//! \brief How a mappedSnapshot maps the file.
+enum class snapshotMode
+{
+    //! \brief Shared & read-only: the processes mapping the same file share the physical pages. Writes fault.
+    readOnly,
+    //! \brief Private & writable: the pages are shared until written to, the writes never reach the file.
+    copyOnWrite
+};
+
+//! \brief Writes \p p_tree to a snapshot file at \p p_path.
+//! \tparam Tree: bTree, recombinantBTree, recombinantTTree or a subclass of these; the Node must be trivially copyable.
+//! \throws std::range_error if the file cannot be written
+template <typename Tree>
+void saveSnapshot(const std::string & p_path, const Tree & p_tree);
+
+//! \brief A snapshot file mapped into memory, validated against its header.
+//! Owns the mapping, so it has to outlive the trees mapped from it, \see mapTree.
+class mappedSnapshot
+{
+public:
+    //! \brief mappedSnapshot
+    //! \param p_path - the snapshot file
+    //! \param p_mode - \see snapshotMode
+    //! \param p_verify - whether to verify the checksum; touches every page of the file
+    //! \throws std::range_error if the file cannot be mapped, is not a snapshot, or the checksum does not match
+    explicit mappedSnapshot(const std::string & p_path, snapshotMode p_mode = snapshotMode::readOnly, bool p_verify = true);
+    mappedSnapshot(const mappedSnapshot &) = delete;
+    mappedSnapshot & operator=(const mappedSnapshot &) = delete;
+    ~mappedSnapshot();
+
+    const snapshotHeader & header() const noexcept;
+    snapshotMode mode() const noexcept;
+    //! \brief The node array.
+    void * data() const noexcept;
+
+    //! \brief Hands out the node array to a single container, \see mappedAllocator.
+    //! \return nullptr if already claimed or if \p p_bytes does not match.
+    void * claim(size_t p_bytes) noexcept;
+
+private:
+    void unmap() noexcept;
+
+    void * m_base{nullptr};
+    size_t m_size{0};
+    snapshotMode m_mode;
+    bool m_claimed{false};
+};
+
+//! \brief A std-conforming allocator that serves the node array of a mappedSnapshot, for zero-copy trees.
+//! Value-initialization is skipped, so the container sees the mapped nodes as they are. Only a single allocation
+//! of the exact size is served, so a container using it cannot be copied or grown.
+template <typename T>
+class mappedAllocator
+{
+public:
+    using value_type = T;
+
+    explicit mappedAllocator(mappedSnapshot & p_snapshot) noexcept;
+    template <typename U>
+    mappedAllocator(const mappedAllocator<U> & p_other) noexcept;
+
+    //! \throws std::bad_alloc on any but the claim of the whole node array
+    T * allocate(size_t p_n);
+    void deallocate(T *, size_t) noexcept {}
+
+    //! \brief Leaves the mapped node as is.
+    template <typename U>
+    void construct(U *) noexcept
+    {
+    }
+    template <typename U, typename... Args>
+    void construct(U * p_ptr, Args &&... p_args);
+
+    mappedSnapshot * snapshot() const noexcept;
+
+private:
+    mappedSnapshot * m_snapshot;
+};
+
+template <typename T, typename U>
+bool operator==(const mappedAllocator<T> & p_lhs, const mappedAllocator<U> & p_rhs) noexcept;
+template <typename T, typename U>
+bool operator!=(const mappedAllocator<T> & p_lhs, const mappedAllocator<U> & p_rhs) noexcept;
+
+//! \brief A tree over the node array of \p p_snapshot, without copying.
+//! With snapshotMode::readOnly only the const interface may be used.
+//! \tparam Tree: recombinantBTree, recombinantTTree or a bTree subclass of the same constructor signature.
+//! \throws std::range_error if the geometry, the node size or the depth do not match.
+template <template <typename, typename> class Tree, typename Node>
+Tree<Node, mappedAllocator<Node>> mapTree(mappedSnapshot & p_snapshot);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace detail
+{
+template <typename Node, typename Alloc>
+constexpr treeGeometry geometryOf(const bTree<Node, Alloc> *) noexcept
+{
+    return treeGeometry::binary;
+}
+
+template <typename Node, typename Alloc>
+constexpr treeGeometry geometryOf(const recombinantBTree<Node, Alloc> *) noexcept
+{
+    return treeGeometry::recombinantB;
+}
+
+template <typename Node, typename Alloc>
+constexpr treeGeometry geometryOf(const recombinantTTree<Node, Alloc> *) noexcept
+{
+    return treeGeometry::recombinantT;
+}
+
+void writeSnapshot(const std::string & p_path, const snapshotHeader & p_header, const void * p_data);
+} // namespace detail
+
+template <typename Tree>
+void saveSnapshot(const std::string & p_path, const Tree & p_tree)
+{
+    using Node = typename Tree::value_type;
+    static_assert(std::is_trivially_copyable_v<Node>, "only trivially copyable nodes can be snapshotted");
+    static_assert(alignof(Node) <= sizeof(snapshotHeader), "the mapped nodes are only aligned to the header size");
+
+    snapshotHeader header{};
+    for (size_t i = 0; i < sizeof(header.magic); ++i)
+    {
+        header.magic[i] = snapshotHeader::magicValue[i];
+    }
+    header.geometry = static_cast<std::uint32_t>(detail::geometryOf(&p_tree));
+    header.nodeSize = sizeof(Node);
+    header.depth = p_tree.numLevels() - 1;
+    header.count = p_tree.totalElems();
+    header.checksum = snapshotChecksum(&p_tree[0], header.count * sizeof(Node));
+
+    detail::writeSnapshot(p_path, header, &p_tree[0]);
+}
+
+// mappedAllocator
+
+template <typename T>
+mappedAllocator<T>::mappedAllocator(mappedSnapshot & p_snapshot) noexcept : m_snapshot(&p_snapshot)
+{}
+
+template <typename T>
+template <typename U>
+mappedAllocator<T>::mappedAllocator(const mappedAllocator<U> & p_other) noexcept : m_snapshot(p_other.snapshot())
+{}
+
+template <typename T>
+T * mappedAllocator<T>::allocate(size_t p_n)
+{
+    void * ret = m_snapshot->claim(p_n * sizeof(T));
+    if (!ret)
+    {
+        throw std::bad_alloc();
+    }
+    return static_cast<T *>(ret);
+}
+
+template <typename T>
+template <typename U, typename... Args>
+void mappedAllocator<T>::construct(U * p_ptr, Args &&... p_args)
+{
+    ::new (static_cast<void *>(p_ptr)) U(std::forward<Args>(p_args)...);
+}
+
+template <typename T>
+mappedSnapshot * mappedAllocator<T>::snapshot() const noexcept
+{
+    return m_snapshot;
+}
+
+template <typename T, typename U>
+bool operator==(const mappedAllocator<T> & p_lhs, const mappedAllocator<U> & p_rhs) noexcept
+{
+    return p_lhs.snapshot() == p_rhs.snapshot();
+}
+
+template <typename T, typename U>
+bool operator!=(const mappedAllocator<T> & p_lhs, const mappedAllocator<U> & p_rhs) noexcept
+{
+    return !(p_lhs == p_rhs);
+}
+
+template <template <typename, typename> class Tree, typename Node>
+Tree<Node, mappedAllocator<Node>> mapTree(mappedSnapshot & p_snapshot)
+{
+    using TreeType = Tree<Node, mappedAllocator<Node>>;
+    static_assert(std::is_trivially_copyable_v<Node>, "only trivially copyable nodes can be snapshotted");
+
+    const snapshotHeader & header = p_snapshot.header();
+    if (header.geometry != static_cast<std::uint32_t>(detail::geometryOf(static_cast<const TreeType *>(nullptr))))
+    {
+        throw std::range_error("mapTree: geometry mismatch");
+    }
+    if (header.nodeSize != sizeof(Node))
+    {
+        throw std::range_error("mapTree: node size mismatch");
+    }
+
+    // the node count is checked by the claim of the allocator
+    try
+    {
+        return TreeType(header.depth, mappedAllocator<Node>(p_snapshot));
+    }
+    catch (const std::bad_alloc &)
+    {
+        throw std::range_error("mapTree: depth mismatch or snapshot already mapped");
+    }
+}
+
+} // namespace cm
+
+#endif // CM_SNAPSHOT_H
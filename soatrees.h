@@ -0,0 +1,232 @@
+/** \file soatrees.h
+ * \author Andrej Leban
+ * \date 10/2026
+ *
+ * Array-based trees with a structure-of-arrays storage.
+ */
+
+#ifndef CM_SOATREES_H
+#define CM_SOATREES_H
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <common/trees.h>
+
+namespace cm
+{
+
+//! \brief A contiguous span of a level of a soaTree, as handed to the induction kernels.
+//! The same as levelSpan, only with a pointer per field: the I-th field of the span's nodes is std::get<I>(current)[i].
+template <typename... Fields>
+struct soaLevelSpan
+{
+    //! \brief The level of the \a current nodes.
+    size_t level;
+    //! \brief The position of the first node of the span within its level.
+    size_t offset;
+    //! \brief The number of nodes in the span on \a level.
+    size_t size;
+    std::tuple<Fields *...> current;
+    std::tuple<const Fields *...> next;
+};
+
+//! \brief A fixed-depth tree that stores each of the node's \p Fields in a separate contiguous array.
+//! A sweep over a single field thus only pulls that field through the cache, & the per-field loops vectorize trivially.
+//! The geometry is that of \p Geometry, the same as in staticTree; operator[] returns a std::tuple of references
+//! to the node's fields as a proxy.
+//! \tparam Geometry: one of the geometries in trees.h or a class of the same interface.
+//! \tparam Fields: the types of the node's fields, e.g. the spot, the option value, ...
+//!  Flags have to be stored as a std::uint8_t or similar, since std::vector<bool> is not contiguous.
+template <typename Geometry, typename... Fields>
+class soaTree : public Geometry
+{
+    static_assert(!(std::is_same_v<Fields, bool> || ...), "soaTree: store flags as std::uint8_t, std::vector<bool> is not contiguous");
+
+public:
+    using value_type = std::tuple<Fields...>;
+    using reference = std::tuple<Fields &...>;
+    using const_reference = std::tuple<const Fields &...>;
+    using geometry = Geometry;
+
+    //! \brief soaTree
+    //! \param depth - number of sub-levels, [0, inf)
+    //! Root is level 0!
+    explicit soaTree(size_t depth);
+
+    //! \brief Insert \p node at \p ind.
+    void insert(size_t ind, const value_type & node);
+    //! \brief Reset the fields at \p ind to their default values.
+    void remove(size_t ind);
+    //! \brief The total number of elements in the tree.
+    size_t totalElems() const;
+    //! \brief The number of total levels - the depth of the tree + 1.
+    size_t numLevels() const;
+
+    //! \brief operator []
+    //! \return A proxy tuple of references to the fields.
+    reference operator[](size_t ind);
+    const_reference operator[](size_t ind) const;
+
+    //! \brief The contiguous array of the \p I-th field for the whole tree.
+    template <size_t I>
+    auto * field();
+    template <size_t I>
+    const auto * field() const;
+
+    //! \brief The contiguous storage of \p level, a pointer per field, starting at its left boundary.
+    //! Only available for the geometries with contiguous levels.
+    std::tuple<Fields *...> levelData(size_t level);
+    std::tuple<const Fields *...> levelData(size_t level) const;
+
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! Only available for the geometries with contiguous levels.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (soaLevelSpan<Fields...>)
+    template <typename Kernel>
+    void backwardInduction(Kernel && kernel);
+
+private:
+    template <size_t... Is>
+    reference at(size_t ind, std::index_sequence<Is...>);
+    template <size_t... Is>
+    const_reference at(size_t ind, std::index_sequence<Is...>) const;
+    template <size_t... Is>
+    std::tuple<Fields *...> levelData(size_t level, std::index_sequence<Is...>);
+    template <size_t... Is>
+    std::tuple<const Fields *...> levelData(size_t level, std::index_sequence<Is...>) const;
+
+    size_t m_depth;
+    std::tuple<std::vector<Fields>...> m_fields;
+};
+
+//! \brief A recombinantBTree with a structure-of-arrays storage.
+template <typename... Fields>
+using soaRecombinantBTree = soaTree<recombinantBGeometry, Fields...>;
+
+//! \brief A recombinantTTree with a structure-of-arrays storage.
+template <typename... Fields>
+using soaRecombinantTTree = soaTree<recombinantTGeometry, Fields...>;
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename Geometry, typename... Fields>
+soaTree<Geometry, Fields...>::soaTree(size_t depth)
+    : m_depth(depth)
+    , m_fields(std::vector<Fields>(Geometry::numElems(depth))...)
+{}
+
+template <typename Geometry, typename... Fields>
+void soaTree<Geometry, Fields...>::insert(size_t ind, const value_type & node)
+{
+    (*this)[ind] = node;
+}
+
+template <typename Geometry, typename... Fields>
+void soaTree<Geometry, Fields...>::remove(size_t ind)
+{
+    (*this)[ind] = value_type{};
+}
+
+template <typename Geometry, typename... Fields>
+size_t soaTree<Geometry, Fields...>::totalElems() const
+{
+    return std::get<0>(m_fields).size();
+}
+
+template <typename Geometry, typename... Fields>
+size_t soaTree<Geometry, Fields...>::numLevels() const
+{
+    return m_depth + 1;
+}
+
+template <typename Geometry, typename... Fields>
+typename soaTree<Geometry, Fields...>::reference soaTree<Geometry, Fields...>::operator[](size_t ind)
+{
+    return at(ind, std::index_sequence_for<Fields...>{});
+}
+
+template <typename Geometry, typename... Fields>
+typename soaTree<Geometry, Fields...>::const_reference soaTree<Geometry, Fields...>::operator[](size_t ind) const
+{
+    return at(ind, std::index_sequence_for<Fields...>{});
+}
+
+template <typename Geometry, typename... Fields>
+template <size_t I>
+auto * soaTree<Geometry, Fields...>::field()
+{
+    return std::get<I>(m_fields).data();
+}
+
+template <typename Geometry, typename... Fields>
+template <size_t I>
+const auto * soaTree<Geometry, Fields...>::field() const
+{
+    return std::get<I>(m_fields).data();
+}
+
+template <typename Geometry, typename... Fields>
+std::tuple<Fields *...> soaTree<Geometry, Fields...>::levelData(size_t level)
+{
+    return levelData(level, std::index_sequence_for<Fields...>{});
+}
+
+template <typename Geometry, typename... Fields>
+std::tuple<const Fields *...> soaTree<Geometry, Fields...>::levelData(size_t level) const
+{
+    return levelData(level, std::index_sequence_for<Fields...>{});
+}
+
+template <typename Geometry, typename... Fields>
+template <typename Kernel>
+void soaTree<Geometry, Fields...>::backwardInduction(Kernel && kernel)
+{
+    CM_PROFILE_SCOPE("soaTree::backwardInduction");
+
+    for (size_t l = m_depth; l-- > 0;)
+    {
+        size_t size = Geometry::right_boundary(l) - Geometry::left_boundary(l) + 1;
+        kernel(soaLevelSpan<Fields...>{l, 0, size, levelData(l), std::as_const(*this).levelData(l + 1)});
+    }
+}
+
+template <typename Geometry, typename... Fields>
+template <size_t... Is>
+typename soaTree<Geometry, Fields...>::reference soaTree<Geometry, Fields...>::at(size_t ind, std::index_sequence<Is...>)
+{
+    return reference(std::get<Is>(m_fields)[ind]...);
+}
+
+template <typename Geometry, typename... Fields>
+template <size_t... Is>
+typename soaTree<Geometry, Fields...>::const_reference soaTree<Geometry, Fields...>::at(size_t ind,
+                                                                                       std::index_sequence<Is...>) const
+{
+    return const_reference(std::get<Is>(m_fields)[ind]...);
+}
+
+template <typename Geometry, typename... Fields>
+template <size_t... Is>
+std::tuple<Fields *...> soaTree<Geometry, Fields...>::levelData(size_t level, std::index_sequence<Is...>)
+{
+    return {(std::get<Is>(m_fields).data() + Geometry::left_boundary(level))...};
+}
+
+template <typename Geometry, typename... Fields>
+template <size_t... Is>
+std::tuple<const Fields *...> soaTree<Geometry, Fields...>::levelData(size_t level, std::index_sequence<Is...>) const
+{
+    return {(std::get<Is>(m_fields).data() + Geometry::left_boundary(level))...};
+}
+
+} // namespace cm
+
+#endif // CM_SOATREES_H
@@ -6,7 +6,15 @@
 #ifndef STACK_H
 #define STACK_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <stack>
+#include <utility>
+#include <vector>
 
 namespace cm {
 
@@ -20,21 +28,21 @@ public:
     using super = std::stack<T,Container>;
     using super::stack;
     ~Stack() = default;
-    Stack( const Stack & ) = default;
-    Stack( Stack && ) noexcept = default;
+    // NOTE: not defaulted - that would bind m_c to the source's container
+    Stack( const Stack & p_other ) : super( p_other ) {}
+    Stack( Stack && p_other ) noexcept : super( std::move( p_other ) ) {}
     using super::operator=;
 
+    // m_c keeps referring to this container
     Stack & operator=( const Stack & p_rhs )
     {
         super::operator=( static_cast<const super &>( p_rhs) );
-        m_c = super::c;
         return *this;
     }
 
     Stack & operator=( Stack && p_rhs ) noexcept
     {
-        super::operator=( std::forward<super>( p_rhs) );
-        m_c = super::c;
+        super::operator=( static_cast<super &&>( p_rhs) );
         return *this;
     }
 
@@ -43,6 +51,315 @@ public:
     Container & m_c = super::c;
 };
 
+//! \brief A lock-free unbounded stack for concurrent producers & consumers, e.g. a shared LIFO work list.
+//! A Treiber stack: the head is swung by a CAS. Against ABA the head carries a 16-bit tag bumped on every change,
+//! packed with the pointer into a single word; the nodes are recycled through an internal free list & only released
+//! with the stack, so a stale read of a popped node stays safe.
+//! The bulk operations link or unlink a whole chain with a single CAS.
+template <typename T>
+class ConcurrentStack
+{
+public:
+    using value_type = T;
+
+    ConcurrentStack() = default;
+    ConcurrentStack(const ConcurrentStack &) = delete;
+    ConcurrentStack & operator=(const ConcurrentStack &) = delete;
+    ~ConcurrentStack();
+
+    void push(const T & p_value) { emplace(p_value); }
+    void push(T && p_value) { emplace(std::move(p_value)); }
+
+    template <typename... Args>
+    void emplace(Args &&... p_args);
+
+    //! \brief Pushes the range [p_first, p_last) with a single CAS, \a p_last - 1 ending up on the top.
+    template <typename InputIt>
+    void push_n(InputIt p_first, InputIt p_last);
+
+    //! \brief Pops the top into \p p_value.
+    //! \return false if the stack is empty.
+    bool pop(T & p_value);
+
+    //! \brief Pops up to \p p_n elements with a single CAS, writing them to \p p_out from the top down.
+    //! \return The number of elements popped.
+    template <typename OutputIt>
+    size_t pop_n(OutputIt p_out, size_t p_n);
+
+    //! \brief The number of elements, approximate while the stack is modified concurrently.
+    size_t size() const noexcept
+    {
+        std::ptrdiff_t ret = m_size.load(std::memory_order_relaxed);
+        return ret > 0 ? static_cast<size_t>(ret) : 0;
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    //! @name Single-owner access
+    //! NOTE: Only valid while no other thread modifies the stack.
+    ///@{
+    //! \brief Calls \p p_func on each element, from the top down.
+    template <typename F>
+    void unsafe_for_each(F && p_func) const;
+    //! \brief A copy of the elements, from the top down.
+    std::vector<T> snapshot() const;
+    ///@}
+
+private:
+    struct node
+    {
+        std::atomic<node *> m_next{nullptr};
+        alignas(T) unsigned char m_value[sizeof(T)];
+
+        T * value() noexcept { return std::launder(reinterpret_cast<T *>(m_value)); }
+    };
+
+    // the nodes are allocated in chunks of
+    static constexpr size_t chunkSize = 64;
+
+    // the tagged head: the pointer in the low 48 bits, the tag in the high 16
+    using tagged = std::uint64_t;
+    static_assert(sizeof(void *) == 8, "ConcurrentStack packs the tag into the upper bits of a 64-bit pointer");
+    static constexpr tagged pointerMask = (tagged{1} << 48) - 1;
+
+    static node * pointer(tagged p_head) noexcept { return reinterpret_cast<node *>(p_head & pointerMask); }
+    static tagged retag(tagged p_old, node * p_new) noexcept
+    {
+        return reinterpret_cast<std::uintptr_t>(p_new) | ((p_old & ~pointerMask) + (pointerMask + 1));
+    }
+
+    static void pushChain(std::atomic<tagged> & p_head, node * p_first, node * p_last) noexcept;
+    // unlinks up to p_n nodes from the top, \return the top & sets p_n to the number of nodes unlinked
+    static node * popChain(std::atomic<tagged> & p_head, size_t & p_n) noexcept;
+
+    node * allocate();
+    void recycle(node * p_first, node * p_last) noexcept { pushChain(m_free, p_first, p_last); }
+
+    alignas(64) std::atomic<tagged> m_head{0};
+    // signed, as a pop may get counted before the push of its element: transiently negative
+    std::atomic<std::ptrdiff_t> m_size{0};
+    alignas(64) std::atomic<tagged> m_free{0};
+    std::mutex m_chunksMutex{};
+    std::vector<std::unique_ptr<node[]>> m_chunks{};
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename T>
+ConcurrentStack<T>::~ConcurrentStack()
+{
+    for (node * current = pointer(m_head.load()); current; current = current->m_next.load(std::memory_order_relaxed))
+    {
+        current->value()->~T();
+    }
+}
+
+template <typename T>
+template <typename... Args>
+void ConcurrentStack<T>::emplace(Args &&... p_args)
+{
+    node * current = allocate();
+    try
+    {
+        ::new (current->m_value) T(std::forward<Args>(p_args)...);
+    }
+    catch (...)
+    {
+        recycle(current, current);
+        throw;
+    }
+
+    pushChain(m_head, current, current);
+    m_size.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+template <typename InputIt>
+void ConcurrentStack<T>::push_n(InputIt p_first, InputIt p_last)
+{
+    // the chain is built privately, p_last - 1 first
+    node * first = nullptr;
+    node * last = nullptr;
+    size_t n = 0;
+
+    try
+    {
+        for (; p_first != p_last; ++p_first, ++n)
+        {
+            node * current = allocate();
+            try
+            {
+                ::new (current->m_value) T(*p_first);
+            }
+            catch (...)
+            {
+                recycle(current, current);
+                throw;
+            }
+
+            current->m_next.store(first, std::memory_order_relaxed);
+            first = current;
+            if (!last)
+            {
+                last = current;
+            }
+        }
+    }
+    catch (...)
+    {
+        for (node * current = first; current; current = current->m_next.load(std::memory_order_relaxed))
+        {
+            current->value()->~T();
+        }
+        if (first)
+        {
+            recycle(first, last);
+        }
+        throw;
+    }
+
+    if (first)
+    {
+        pushChain(m_head, first, last);
+        m_size.fetch_add(static_cast<std::ptrdiff_t>(n), std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+bool ConcurrentStack<T>::pop(T & p_value)
+{
+    size_t n = 1;
+    node * top = popChain(m_head, n);
+    if (!top)
+    {
+        return false;
+    }
+    m_size.fetch_sub(1, std::memory_order_relaxed);
+
+    p_value = std::move(*top->value());
+    top->value()->~T();
+    recycle(top, top);
+
+    return true;
+}
+
+template <typename T>
+template <typename OutputIt>
+size_t ConcurrentStack<T>::pop_n(OutputIt p_out, size_t p_n)
+{
+    size_t n = p_n;
+    node * top = popChain(m_head, n);
+    if (!top)
+    {
+        return 0;
+    }
+    m_size.fetch_sub(static_cast<std::ptrdiff_t>(n), std::memory_order_relaxed);
+
+    // the chain of n nodes is private now, the next of its last one is stale
+    node * last = top;
+    for (size_t i = 0; i < n; ++i, ++p_out)
+    {
+        last = i ? last->m_next.load(std::memory_order_relaxed) : top;
+        *p_out = std::move(*last->value());
+        last->value()->~T();
+    }
+    recycle(top, last);
+
+    return n;
+}
+
+template <typename T>
+template <typename F>
+void ConcurrentStack<T>::unsafe_for_each(F && p_func) const
+{
+    for (node * current = pointer(m_head.load(std::memory_order_acquire)); current;
+         current = current->m_next.load(std::memory_order_relaxed))
+    {
+        p_func(std::as_const(*current->value()));
+    }
+}
+
+template <typename T>
+std::vector<T> ConcurrentStack<T>::snapshot() const
+{
+    std::vector<T> ret;
+    ret.reserve(size());
+    unsafe_for_each([&ret](const T & p_value) { ret.push_back(p_value); });
+    return ret;
+}
+
+template <typename T>
+void ConcurrentStack<T>::pushChain(std::atomic<tagged> & p_head, node * p_first, node * p_last) noexcept
+{
+    tagged old = p_head.load(std::memory_order_relaxed);
+    do
+    {
+        p_last->m_next.store(pointer(old), std::memory_order_relaxed);
+    } while (!p_head.compare_exchange_weak(old, retag(old, p_first), std::memory_order_release, std::memory_order_relaxed));
+}
+
+template <typename T>
+typename ConcurrentStack<T>::node * ConcurrentStack<T>::popChain(std::atomic<tagged> & p_head, size_t & p_n) noexcept
+{
+    if (p_n == 0)
+    {
+        return nullptr;
+    }
+
+    tagged old = p_head.load(std::memory_order_acquire);
+    for (;;)
+    {
+        node * top = pointer(old);
+        if (!top)
+        {
+            p_n = 0;
+            return nullptr;
+        }
+
+        // the nodes read may be popped & recycled concurrently, then the tag has changed & the CAS fails
+        size_t n = 1;
+        node * next = top->m_next.load(std::memory_order_relaxed);
+        for (; n < p_n && next; ++n)
+        {
+            next = next->m_next.load(std::memory_order_relaxed);
+        }
+
+        if (p_head.compare_exchange_weak(old, retag(old, next), std::memory_order_acquire, std::memory_order_acquire))
+        {
+            p_n = n;
+            return top;
+        }
+    }
+}
+
+template <typename T>
+typename ConcurrentStack<T>::node * ConcurrentStack<T>::allocate()
+{
+    size_t n = 1;
+    if (node * ret = popChain(m_free, n))
+    {
+        return ret;
+    }
+
+    auto chunk = std::make_unique<node[]>(chunkSize);
+    node * ret = &chunk[0];
+    // the rest goes to the free list
+    for (size_t i = 1; i + 1 < chunkSize; ++i)
+    {
+        chunk[i].m_next.store(&chunk[i + 1], std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard lk(m_chunksMutex);
+        m_chunks.push_back(std::move(chunk));
+    }
+    recycle(ret + 1, ret + chunkSize - 1);
+
+    return ret;
+}
+
 } // namespace cm
 
 #endif // STACK_H
@@ -6,6 +6,11 @@
 #ifndef STACKCONTAINER_H
 #define STACKCONTAINER_H
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -162,6 +167,301 @@ private:
     size_t m_top {0};
 };
 
+
+//! @name Growth policies of the InlineStackContainer
+///@{
+
+//! \brief The capacity is fixed, exceeding it throws std::range_error.
+struct fixedCapacity
+{
+    static constexpr bool grows = false;
+};
+
+//! \brief The storage moves to the heap once the inline capacity is exceeded, doubling on each further overflow.
+struct geometricGrowth
+{
+    static constexpr bool grows = true;
+    static constexpr size_t next(size_t p_capacity) { return std::max<size_t>(2 * p_capacity, 8); }
+};
+///@}
+
+//! \brief A stack container with inline storage for \p N elements, to be used as the Container of cm::Stack,
+//! e.g. as the DFS stack in tree traversals.
+//! The elements live inside the object up to \p N, so a small stack never touches the heap; beyond that
+//! the \p Growth policy decides. Every operation is O(1), amortized with geometricGrowth; the storage never shrinks.
+template <typename T, size_t N, typename Growth = fixedCapacity>
+class InlineStackContainer
+{
+public:
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    InlineStackContainer() noexcept = default;
+    InlineStackContainer(const InlineStackContainer & p_other);
+    InlineStackContainer(InlineStackContainer && p_other) noexcept(std::is_nothrow_move_constructible_v<T>);
+    InlineStackContainer & operator=(const InlineStackContainer & p_other);
+    InlineStackContainer & operator=(InlineStackContainer && p_other) noexcept(std::is_nothrow_move_constructible_v<T>);
+    ~InlineStackContainer();
+
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    size_t capacity() const noexcept { return m_capacity; }
+    //! \brief Whether the elements are still stored inline.
+    bool isInline() const noexcept { return m_data == inlineData(); }
+
+    //! \brief Makes room for \p p_capacity elements; beyond \p N only with a growing policy.
+    void reserve(size_t p_capacity);
+
+    T & back() { return m_data[m_size - 1]; }
+    const T & back() const { return m_data[m_size - 1]; }
+    T & front() { return m_data[0]; }
+    const T & front() const { return m_data[0]; }
+
+    T & operator[](size_t pos) { return m_data[pos]; }
+    const T & operator[](size_t pos) const { return m_data[pos]; }
+
+    T * data() noexcept { return m_data; }
+    const T * data() const noexcept { return m_data; }
+
+    iterator begin() noexcept { return m_data; }
+    iterator end() noexcept { return m_data + m_size; }
+    const_iterator begin() const noexcept { return m_data; }
+    const_iterator end() const noexcept { return m_data + m_size; }
+
+    void push_back(const T & value) { emplace_back(value); }
+    void push_back(T && value) { emplace_back(std::move(value)); }
+
+    template <class... Args>
+    T & emplace_back(Args &&... args);
+
+    void pop_back() noexcept;
+    void clear() noexcept;
+
+private:
+    T * inlineData() const noexcept { return reinterpret_cast<T *>(const_cast<unsigned char *>(m_inline)); }
+    // moves the elements to a heap buffer of p_capacity
+    void grow(size_t p_capacity);
+    static T * allocate(size_t p_capacity);
+    static void deallocate(T * p_data) noexcept;
+    // moves the elements to p_data, a heap buffer of p_capacity, & switches to it; p_data is kept on a throw
+    void relocate(T * p_data, size_t p_capacity);
+    // this is empty & inline
+    void take(InlineStackContainer && p_other) noexcept(std::is_nothrow_move_constructible_v<T>);
+    void release() noexcept;
+
+    alignas(T) unsigned char m_inline[N == 0 ? 1 : N * sizeof(T)];
+    T * m_data{inlineData()};
+    size_t m_size{0};
+    size_t m_capacity{N};
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename T, size_t N, typename Growth>
+InlineStackContainer<T, N, Growth>::InlineStackContainer(const InlineStackContainer & p_other)
+{
+    reserve(p_other.m_size);
+    for (const T & value : p_other)
+    {
+        emplace_back(value);
+    }
+}
+
+template <typename T, size_t N, typename Growth>
+InlineStackContainer<T, N, Growth>::InlineStackContainer(InlineStackContainer && p_other) noexcept(
+    std::is_nothrow_move_constructible_v<T>)
+{
+    take(std::move(p_other));
+}
+
+template <typename T, size_t N, typename Growth>
+InlineStackContainer<T, N, Growth> & InlineStackContainer<T, N, Growth>::operator=(const InlineStackContainer & p_other)
+{
+    if (this != &p_other)
+    {
+        clear();
+        reserve(p_other.m_size);
+        for (const T & value : p_other)
+        {
+            emplace_back(value);
+        }
+    }
+    return *this;
+}
+
+template <typename T, size_t N, typename Growth>
+InlineStackContainer<T, N, Growth> & InlineStackContainer<T, N, Growth>::operator=(InlineStackContainer && p_other) noexcept(
+    std::is_nothrow_move_constructible_v<T>)
+{
+    if (this != &p_other)
+    {
+        release();
+        take(std::move(p_other));
+    }
+    return *this;
+}
+
+template <typename T, size_t N, typename Growth>
+InlineStackContainer<T, N, Growth>::~InlineStackContainer()
+{
+    release();
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::reserve(size_t p_capacity)
+{
+    if (p_capacity <= m_capacity)
+    {
+        return;
+    }
+
+    if constexpr (Growth::grows)
+    {
+        grow(p_capacity);
+    }
+    else
+    {
+        throw std::range_error("InlineStackContainer: the fixed capacity exceeded");
+    }
+}
+
+template <typename T, size_t N, typename Growth>
+template <class... Args>
+T & InlineStackContainer<T, N, Growth>::emplace_back(Args &&... args)
+{
+    if (m_size == m_capacity)
+    {
+        if constexpr (Growth::grows)
+        {
+            // the new element goes first, as the arguments may refer to the current ones, e.g. push_back(back())
+            const size_t capacity = Growth::next(m_capacity);
+            T * data = allocate(capacity);
+            T * ret;
+            try
+            {
+                ret = ::new (data + m_size) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                deallocate(data);
+                throw;
+            }
+
+            try
+            {
+                relocate(data, capacity);
+            }
+            catch (...)
+            {
+                ret->~T();
+                deallocate(data);
+                throw;
+            }
+            ++m_size;
+            return *ret;
+        }
+        else
+        {
+            throw std::range_error("InlineStackContainer: the fixed capacity exceeded");
+        }
+    }
+
+    T * ret = ::new (m_data + m_size) T(std::forward<Args>(args)...);
+    ++m_size;
+    return *ret;
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::pop_back() noexcept
+{
+    --m_size;
+    m_data[m_size].~T();
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::clear() noexcept
+{
+    std::destroy(begin(), end());
+    m_size = 0;
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::grow(size_t p_capacity)
+{
+    T * data = allocate(p_capacity);
+
+    try
+    {
+        relocate(data, p_capacity);
+    }
+    catch (...)
+    {
+        deallocate(data);
+        throw;
+    }
+}
+
+template <typename T, size_t N, typename Growth>
+T * InlineStackContainer<T, N, Growth>::allocate(size_t p_capacity)
+{
+    return static_cast<T *>(::operator new(p_capacity * sizeof(T), std::align_val_t{alignof(T)}));
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::deallocate(T * p_data) noexcept
+{
+    ::operator delete(p_data, std::align_val_t{alignof(T)});
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::relocate(T * p_data, size_t p_capacity)
+{
+    std::uninitialized_move(begin(), end(), p_data);
+
+    size_t size = m_size;
+    release();
+    m_data = p_data;
+    m_size = size;
+    m_capacity = p_capacity;
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::take(InlineStackContainer && p_other) noexcept(std::is_nothrow_move_constructible_v<T>)
+{
+    if (!p_other.isInline())
+    {
+        // take over the heap buffer
+        m_data = std::exchange(p_other.m_data, p_other.inlineData());
+        m_size = std::exchange(p_other.m_size, 0);
+        m_capacity = std::exchange(p_other.m_capacity, N);
+        return;
+    }
+
+    std::uninitialized_move(p_other.begin(), p_other.end(), m_data);
+    m_size = p_other.m_size;
+    p_other.clear();
+}
+
+template <typename T, size_t N, typename Growth>
+void InlineStackContainer<T, N, Growth>::release() noexcept
+{
+    clear();
+    if (!isInline())
+    {
+        deallocate(m_data);
+        m_data = inlineData();
+        m_capacity = N;
+    }
+}
+
 } // namespace cm
 
 #endif // STACKCONTAINER_H
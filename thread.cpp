@@ -5,9 +5,139 @@
 
 #include "thread.h"
 
+#include <algorithm>
+#include <ostream>
+
 namespace cm
 {
 
+namespace
+{
+
+// the pool & queue of the calling worker thread
+thread_local const ThreadPool * tl_pool = nullptr;
+thread_local size_t tl_queue = 0;
+
+// the slots of the calling thread at the TreeBarriers it arrived at without an id
+struct treeSlot
+{
+    std::uint64_t m_serial;
+    std::weak_ptr<void> m_alive;
+    unsigned m_slot;
+};
+thread_local std::vector<treeSlot> tl_treeSlots;
+// the last of those, sparing the lookup when the thread stays with one barrier
+thread_local std::uint64_t tl_treeBarrier = 0;
+thread_local unsigned tl_treeSlot = 0;
+std::atomic<std::uint64_t> g_treeBarriers{0};
+
+} // namespace
+
+
+#ifdef CM_BARRIER_STATS
+
+void detail::barrierRecorder::release(timePoint p_time) noexcept
+{
+    std::uint64_t skew = static_cast<std::uint64_t>(p_time - m_phaseStart.exchange(0, std::memory_order_relaxed));
+
+    std::lock_guard lk(m_mutex);
+    m_totalSkew += skew;
+    m_maxSkew = std::max(m_maxSkew, skew);
+
+    auto id = std::this_thread::get_id();
+    auto it = std::find_if(m_lastArrivals.begin(), m_lastArrivals.end(), [id](const auto & p) { return p.first == id; });
+    if (it == m_lastArrivals.end())
+    {
+        // can't report an allocation failure from here, the phase is merely not attributed
+        try
+        {
+            m_lastArrivals.emplace_back(id, 1);
+        }
+        catch (...)
+        {
+        }
+    }
+    else
+    {
+        ++it->second;
+    }
+}
+
+void detail::barrierRecorder::waited(timePoint p_since, bool p_parked) noexcept
+{
+    std::uint64_t duration = static_cast<std::uint64_t>(std::max<timePoint>(now() - p_since, 0));
+
+    if (p_parked)
+    {
+        ++m_parkedWaits;
+        m_parkedTime += duration;
+    }
+    else
+    {
+        ++m_spinWaits;
+        m_spinTime += duration;
+    }
+
+    size_t bucket = 0;
+    for (std::uint64_t d = duration; d > 1 && bucket + 1 < m_waitHistogram.size(); d >>= 1)
+    {
+        ++bucket;
+    }
+    ++m_waitHistogram[bucket];
+}
+
+barrierStats detail::barrierRecorder::stats() const
+{
+    barrierStats ret;
+    ret.arrivals = m_arrivals;
+    ret.dropouts = m_dropouts;
+    ret.spinWaits = m_spinWaits;
+    ret.parkedWaits = m_parkedWaits;
+    ret.spinTime = m_spinTime;
+    ret.parkedTime = m_parkedTime;
+    for (size_t i = 0; i < m_waitHistogram.size(); ++i)
+    {
+        ret.waitHistogram[i] = m_waitHistogram[i];
+    }
+
+    std::lock_guard lk(m_mutex);
+    ret.totalSkew = m_totalSkew;
+    ret.maxSkew = m_maxSkew;
+    ret.lastArrivals = m_lastArrivals;
+
+    return ret;
+}
+
+#endif
+
+std::ostream & operator<<(std::ostream & p_os, const barrierStats & p_stats)
+{
+    p_os << "phases: " << p_stats.phases << ", arrivals: " << p_stats.arrivals << ", dropouts: " << p_stats.dropouts << '\n';
+    p_os << "spin waits: " << p_stats.spinWaits << " (" << p_stats.spinTime << " ns), parked waits: " << p_stats.parkedWaits
+         << " (" << p_stats.parkedTime << " ns)\n";
+    if (p_stats.phases != 0)
+    {
+        p_os << "arrival skew: mean " << p_stats.totalSkew / p_stats.phases << " ns, max " << p_stats.maxSkew << " ns\n";
+    }
+
+    p_os << "wait histogram:";
+    for (size_t i = 0; i < p_stats.waitHistogram.size(); ++i)
+    {
+        if (p_stats.waitHistogram[i] != 0)
+        {
+            p_os << " [2^" << i << "]: " << p_stats.waitHistogram[i];
+        }
+    }
+    p_os << '\n';
+
+    for (const auto & [id, count] : p_stats.lastArrivals)
+    {
+        p_os << "last arrival: thread " << id << ": " << count << '\n';
+    }
+
+    return p_os;
+}
+
 
 SpinLockBarrier::SpinLockBarrier(unsigned p_nThreads) : m_nThreads(p_nThreads), m_counter(m_nThreads.load()) {}
 
@@ -17,12 +147,16 @@ void SpinLockBarrier::arrive_and_wait() noexcept
     {
         return;
     }
+    CM_PROFILE_TIMER("SpinLockBarrier::arrive_and_wait");
 
     size_t numResets = m_numResets;
+    auto arrival = m_stats.now();
+    m_stats.arrive(arrival);
 
     if (--m_counter == 0)
     {
         // launch the waiting threads
+        m_stats.release(arrival);
         m_counter = m_nThreads.load();
         m_numResets++;
     }
@@ -32,6 +166,7 @@ void SpinLockBarrier::arrive_and_wait() noexcept
         {
             std::this_thread::yield();
         }
+        m_stats.waited(arrival, false);
     }
 }
 
@@ -43,14 +178,25 @@ void SpinLockBarrier::arrive_and_drop() noexcept
     }
 
     --m_nThreads;
+    auto arrival = m_stats.now();
+    m_stats.dropped();
+    m_stats.arrive(arrival);
 
     if (--m_counter == 0)
     {
+        m_stats.release(arrival);
         m_counter = m_nThreads.load();
         m_numResets++;
     }
 }
 
+barrierStats SpinLockBarrier::stats() const
+{
+    barrierStats ret = m_stats.stats();
+    ret.phases = m_numResets;
+    return ret;
+}
+
 
 Barrier::Barrier(unsigned p_nThreads) : SpinLockBarrier(p_nThreads) {}
 
@@ -60,16 +206,23 @@ void Barrier::arrive_and_wait() noexcept
     {
         return;
     }
+    CM_PROFILE_TIMER("Barrier::arrive_and_wait");
 
     size_t numResets = m_numResets;
+    auto arrival = m_stats.now();
+    m_stats.arrive(arrival);
 
     std::unique_lock lk(m_mutex, std::defer_lock);
 
     if (--m_counter == 0)
     {
         // launch the waiting threads
+        // the reset is published under the lock, else a waiter could miss it between its check & blocking
+        m_stats.release(arrival);
         m_counter = m_nThreads.load();
+        lk.lock();
         m_numResets++;
+        lk.unlock();
         m_condvar.notify_all();
     }
     else
@@ -77,6 +230,7 @@ void Barrier::arrive_and_wait() noexcept
         lk.lock();
         m_condvar.wait(lk, [this, numResets]() { return numResets != m_numResets; });
         lk.unlock();
+        m_stats.waited(arrival, true);
     }
 }
 
@@ -88,43 +242,84 @@ void Barrier::arrive_and_drop() noexcept
     }
 
     --m_nThreads;
+    auto arrival = m_stats.now();
+    m_stats.dropped();
+    m_stats.arrive(arrival);
 
     if (--m_counter == 0)
     {
+        m_stats.release(arrival);
         m_counter = m_nThreads.load();
-        m_numResets++;
+        {
+            std::lock_guard lk(m_mutex);
+            m_numResets++;
+        }
         m_condvar.notify_all();
     }
 }
 
-FlexBarrier::FlexBarrier(unsigned p_nThreads) : FlexBarrier(p_nThreads, []() noexcept { return -1; }) {}
 
-FlexBarrier::FlexBarrier(unsigned p_nThreads, FlexBarrier::comp_func p_func) : Barrier(p_nThreads), m_func(std::move(p_func)) {}
+HybridBarrier::HybridBarrier(unsigned p_nThreads, unsigned p_spinBudget)
+    : SpinLockBarrier(p_nThreads), m_fixedBudget(std::min(p_spinBudget, maxSpins))
+{
+}
 
-void FlexBarrier::arrive_and_wait() noexcept
+unsigned HybridBarrier::spinBudget() const noexcept
+{
+    if (m_fixedBudget != 0)
+    {
+        return m_fixedBudget;
+    }
+    return std::min(2 * m_spinEstimate.load(std::memory_order_relaxed), maxSpins);
+}
+
+void HybridBarrier::arrive_and_wait() noexcept
 {
     if (m_nThreads == 0)
     {
         return;
     }
+    CM_PROFILE_TIMER("HybridBarrier::arrive_and_wait");
 
     size_t numResets = m_numResets;
-
-    std::unique_lock lk(m_mutex, std::defer_lock);
+    auto arrival = m_stats.now();
+    m_stats.arrive(arrival);
 
     if (--m_counter == 0)
     {
+        m_stats.release(arrival);
         release();
+        return;
+    }
+
+    const unsigned budget = spinBudget();
+    unsigned spins = 0;
+    for (; spins < budget; ++spins)
+    {
+        if (numResets != m_numResets.load(std::memory_order_acquire))
+        {
+            break;
+        }
+        cpuRelax();
+    }
+
+    // a racy update of the estimate is harmless, it's a heuristic
+    unsigned estimate = m_spinEstimate.load(std::memory_order_relaxed);
+    if (spins < budget)
+    {
+        m_stats.waited(arrival, false);
+        estimate += (static_cast<int>(spins) - static_cast<int>(estimate)) / 8;
     }
     else
     {
-        lk.lock();
-        m_condvar.wait(lk, [this, numResets]() { return numResets != m_numResets; });
-        lk.unlock();
+        park(numResets);
+        m_stats.waited(arrival, true);
+        estimate -= estimate / 8;
     }
+    m_spinEstimate.store(std::max(estimate, minSpins), std::memory_order_relaxed);
 }
 
-void FlexBarrier::arrive_and_drop() noexcept
+void HybridBarrier::arrive_and_drop() noexcept
 {
     if (m_nThreads == 0)
     {
@@ -132,24 +327,469 @@ void FlexBarrier::arrive_and_drop() noexcept
     }
 
     --m_nThreads;
+    auto arrival = m_stats.now();
+    m_stats.dropped();
+    m_stats.arrive(arrival);
 
     if (--m_counter == 0)
     {
+        m_stats.release(arrival);
         release();
     }
 }
 
-void FlexBarrier::release() noexcept
+void HybridBarrier::release() noexcept
 {
-    std::ptrdiff_t ret = m_func();
-    if(ret >= 0)
+    m_counter = m_nThreads.load();
+
+    // the increment & the check of the parked waiters are both sequentially consistent, so either the waiter sees
+    // the new phase before parking or the release sees the waiter
+#ifdef CM_ATOMIC_WAIT
+    m_numResets++;
+    if (m_parked != 0)
     {
-        m_nThreads = static_cast<unsigned>(ret);
+        m_numResets.notify_all();
     }
-    m_counter = m_nThreads.load();
+#else
     m_numResets++;
+    if (m_parked != 0)
+    {
+        // the lock orders the notification after a waiter's check of the predicate
+        {
+            std::lock_guard lk(m_mutex);
+        }
+        m_condvar.notify_all();
+    }
+#endif
+}
+
+void HybridBarrier::park(size_t p_numResets) noexcept
+{
+    ++m_parked;
+#ifdef CM_ATOMIC_WAIT
+    for (unsigned long current = p_numResets; current == p_numResets; current = m_numResets.load())
+    {
+        m_numResets.wait(current);
+    }
+#else
+    {
+        std::unique_lock lk(m_mutex);
+        m_condvar.wait(lk, [this, p_numResets]() { return p_numResets != m_numResets; });
+    }
+#endif
+    --m_parked;
+}
+
+
+TreeBarrier::TreeBarrier(unsigned p_nThreads, unsigned p_fanIn)
+    : m_nThreads(p_nThreads), m_fanIn(std::max(p_fanIn, 2u)), m_serial(++g_treeBarriers),
+      m_slots(p_nThreads), m_alive(std::make_shared<char>())
+{
+    // the levels are laid out contiguously from the leaves up, the threads being the children of the leaves
+    size_t total = 0;
+    for (size_t width = std::max(p_nThreads, 1u);;)
+    {
+        width = (width + m_fanIn - 1) / m_fanIn;
+        total += width;
+        if (width == 1)
+        {
+            break;
+        }
+    }
+
+    m_nodes = std::make_unique<node[]>(total);
+    m_root = total - 1;
+
+    size_t first = 0;
+    size_t children = p_nThreads;
+    for (size_t width = std::max(p_nThreads, 1u);;)
+    {
+        width = (width + m_fanIn - 1) / m_fanIn;
+        for (size_t i = 0; i < width; ++i)
+        {
+            unsigned expected = static_cast<unsigned>(std::min<size_t>(m_fanIn, children - i * m_fanIn));
+            m_nodes[first + i].m_counter = expected;
+            m_nodes[first + i].m_expected = expected;
+            m_nodes[first + i].m_parent = first + width + i / m_fanIn;
+        }
+
+        first += width;
+        children = width;
+        if (width == 1)
+        {
+            break;
+        }
+    }
+}
+
+void TreeBarrier::arrive_and_wait()
+{
+    arrive_and_wait(localId());
+}
+
+void TreeBarrier::arrive_and_drop()
+{
+    arrive_and_drop(localId());
+}
+
+void TreeBarrier::arrive_and_wait(unsigned p_id) noexcept
+{
+    if (m_nThreads == 0)
+    {
+        return;
+    }
+    CM_PROFILE_TIMER("TreeBarrier::arrive_and_wait");
+
+    size_t numResets = m_numResets.load(std::memory_order_acquire);
+    auto arrival = m_stats.now();
+    m_stats.arrive(arrival);
+
+    if (arrive(p_id / m_fanIn, false, arrival))
+    {
+        return;
+    }
+
+    for (unsigned spins = 0; numResets == m_numResets.load(std::memory_order_acquire); ++spins)
+    {
+        if (spins < 1024)
+        {
+            cpuRelax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    m_stats.waited(arrival, false);
+}
+
+void TreeBarrier::arrive_and_drop(unsigned p_id) noexcept
+{
+    if (m_nThreads == 0)
+    {
+        return;
+    }
+
+    --m_nThreads;
+    auto arrival = m_stats.now();
+    m_stats.dropped();
+    m_stats.arrive(arrival);
+    arrive(p_id / m_fanIn, true, arrival);
+}
+
+barrierStats TreeBarrier::stats() const
+{
+    barrierStats ret = m_stats.stats();
+    ret.phases = m_numResets;
+    return ret;
+}
+
+unsigned TreeBarrier::localId()
+{
+    if (tl_treeBarrier == m_serial)
+    {
+        return tl_treeSlot;
+    }
+
+    // a thread alternating between the barriers finds its slot in its own cache, without touching the shared state
+    auto found = std::find_if(tl_treeSlots.begin(), tl_treeSlots.end(),
+                              [this](const treeSlot & p_entry) { return p_entry.m_serial == m_serial; });
+    if (found == tl_treeSlots.end())
+    {
+        const unsigned slot = m_drawn.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= m_slots)
+        {
+            throw std::range_error("TreeBarrier: more threads arriving than participating");
+        }
+
+        // the entries of the destroyed barriers make room first, bounding the cache by the barriers alive
+        tl_treeSlots.erase(std::remove_if(tl_treeSlots.begin(), tl_treeSlots.end(),
+                                          [](const treeSlot & p_entry) { return p_entry.m_alive.expired(); }),
+                           tl_treeSlots.end());
+        found = tl_treeSlots.insert(tl_treeSlots.end(), treeSlot{m_serial, m_alive, slot});
+    }
+
+    tl_treeBarrier = m_serial;
+    tl_treeSlot = found->m_slot;
+    return tl_treeSlot;
+}
+
+bool TreeBarrier::arrive(size_t p_node, bool p_drop, detail::barrierRecorder::timePoint p_time) noexcept
+{
+    for (;;)
+    {
+        node & current = m_nodes[p_node];
+
+        // a drop is accounted for before arriving, so that the last arrival resets to the new count
+        if (p_drop)
+        {
+            --current.m_expected;
+        }
+
+        if (--current.m_counter != 0)
+        {
+            return false;
+        }
+
+        // the last arrival at this node proceeds up, dropping the node out of its parent once it is empty
+        unsigned expected = current.m_expected;
+        current.m_counter = expected;
+
+        if (p_node == m_root)
+        {
+            // launch the waiting threads
+            m_stats.release(p_time);
+            m_numResets.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        p_drop = expected == 0;
+        p_node = current.m_parent;
+    }
+}
+
+
+ThreadPool::ThreadPool(unsigned p_nThreads)
+{
+    if (p_nThreads == 0)
+    {
+        p_nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_size = p_nThreads;
+    m_queues = std::make_unique<queue[]>(p_nThreads);
+    m_threads.reserve(p_nThreads);
+    for (size_t i = 0; i < p_nThreads; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lk(m_mutex);
+        m_stop = true;
+    }
     m_condvar.notify_all();
+
+    for (auto & thread : m_threads)
+    {
+        thread.join();
+    }
 }
 
+void ThreadPool::post(task p_task)
+{
+    push(localQueue(), std::move(p_task));
+
+    // the lock orders the notification after a worker's check of the predicate
+    {
+        std::lock_guard lk(m_mutex);
+    }
+    m_condvar.notify_one();
+}
+
+bool ThreadPool::tryRunOne()
+{
+    task current;
+    size_t local = localQueue();
+    if (pop(local, current) || steal(local, current))
+    {
+        current();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::push(size_t p_queue, task p_task)
+{
+    {
+        std::lock_guard lk(m_queues[p_queue].m_mutex);
+        m_queues[p_queue].m_tasks.push_back(std::move(p_task));
+    }
+    ++m_pending;
+    m_helpers.notify();
+}
+
+bool ThreadPool::pop(size_t p_queue, task & p_task)
+{
+    std::lock_guard lk(m_queues[p_queue].m_mutex);
+    auto & tasks = m_queues[p_queue].m_tasks;
+    if (tasks.empty())
+    {
+        return false;
+    }
+
+    p_task = std::move(tasks.back());
+    tasks.pop_back();
+    --m_pending;
+    return true;
+}
+
+bool ThreadPool::steal(size_t p_queue, task & p_task)
+{
+    for (size_t i = 1; i < size(); ++i)
+    {
+        queue & victim = m_queues[(p_queue + i) % size()];
+        std::lock_guard lk(victim.m_mutex);
+        if (!victim.m_tasks.empty())
+        {
+            p_task = std::move(victim.m_tasks.front());
+            victim.m_tasks.pop_front();
+            --m_pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t p_queue)
+{
+    tl_pool = this;
+    tl_queue = p_queue;
+    queue & own = m_queues[p_queue];
+
+    for (;;)
+    {
+        int expected = workerIdle;
+        if (own.m_state.compare_exchange_strong(expected, workerBusy))
+        {
+            task current;
+            bool found = pop(p_queue, current) || steal(p_queue, current);
+            if (found)
+            {
+                current();
+            }
+            own.m_state.store(workerIdle);
+            if (found)
+            {
+                continue;
+            }
+
+            std::unique_lock lk(m_mutex);
+            m_condvar.wait(lk, [this, &own]() { return m_stop || m_pending != 0 || own.m_state == workerReserved; });
+            if (own.m_state == workerReserved)
+            {
+                // the wake-up may have been meant for a queued task, pass it on to an idle worker
+                if (m_pending != 0)
+                {
+                    m_condvar.notify_one();
+                }
+            }
+            else if (m_stop && m_pending == 0)
+            {
+                return;
+            }
+            continue;
+        }
+
+        // reserved for a team: wait for the member, unless released unused
+        task member;
+        {
+            std::unique_lock lk(m_mutex);
+            own.m_wake.wait(lk, [&own]() { return own.m_member || own.m_state != workerReserved; });
+            member = std::move(own.m_member);
+            own.m_member = nullptr;
+        }
+        if (member)
+        {
+            member();
+            // only now, so that a team reserving this worker meanwhile cannot be overwritten
+            own.m_state.store(workerIdle);
+        }
+    }
+}
+
+ThreadPool::team ThreadPool::reserveTeam(unsigned p_n)
+{
+    std::vector<size_t> workers;
+    if (p_n > 1)
+    {
+        workers.reserve(std::min<size_t>(p_n - 1, size()));
+    }
+
+    // the calling worker is busy, so it is never reserved
+    const size_t start = localQueue();
+    for (size_t i = 0; i < size() && workers.size() + 1 < p_n; ++i)
+    {
+        size_t worker = (start + i) % size();
+        int expected = workerIdle;
+        if (m_queues[worker].m_state.compare_exchange_strong(expected, workerReserved))
+        {
+            workers.push_back(worker);
+        }
+    }
+
+    return team(*this, std::move(workers));
+}
+
+size_t ThreadPool::localQueue() noexcept
+{
+    if (tl_pool == this)
+    {
+        return tl_queue;
+    }
+    return m_next++ % size();
+}
+
+
+ThreadPool::team::team(ThreadPool & p_pool, std::vector<size_t> p_workers) noexcept
+    : m_pool(&p_pool), m_workers(std::move(p_workers))
+{}
+
+ThreadPool::team::team(team && p_other) noexcept : m_pool(p_other.m_pool), m_workers(std::move(p_other.m_workers))
+{
+    p_other.m_workers.clear();
+}
+
+ThreadPool::team::~team()
+{
+    release();
+}
+
+void ThreadPool::team::release() noexcept
+{
+    if (m_workers.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lk(m_pool->m_mutex);
+        for (size_t worker : m_workers)
+        {
+            m_pool->m_queues[worker].m_state.store(workerIdle);
+        }
+    }
+    for (size_t worker : m_workers)
+    {
+        m_pool->m_queues[worker].m_wake.notify_one();
+    }
+    m_workers.clear();
+}
+
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+void TaskGroup::wait()
+{
+    m_pool.helpUntil([this]() { return m_pending == 0; });
+
+    std::lock_guard lk(m_mutex);
+    if (m_exception)
+    {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
 
 } // namespace cm
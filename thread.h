@@ -8,14 +8,154 @@
 #ifndef CM_THREAD_H
 #define CM_THREAD_H
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tools.h"
+
+#if defined(__cpp_lib_atomic_wait)
+#define CM_ATOMIC_WAIT
+#endif
 
 namespace cm
 {
 
+//! \brief The assumed size of a cache line, for keeping the shared state of different writers apart.
+inline constexpr size_t cacheLineSize = 64;
+
+//! \brief Hints the CPU that the thread is busy-waiting.
+inline void cpuRelax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////// barrier statistics ////////////////////////////////////
+
+//! \brief The synchronization statistics of a barrier.
+//! Recorded only with CM_BARRIER_STATS defined (the BARRIER_STATS build option), else all but \a phases stay 0.
+//! The times are in nanoseconds.
+struct barrierStats
+{
+    //! the number of completed synchronizations
+    size_t phases{0};
+    size_t arrivals{0};
+    size_t dropouts{0};
+
+    //! @name The waits of the threads that were not the last to arrive
+    ///@{
+    size_t spinWaits{0};
+    size_t parkedWaits{0};
+    std::uint64_t spinTime{0};
+    std::uint64_t parkedTime{0};
+    //! waits by the power of 2 of their duration: bucket i counts the waits in [2^i, 2^(i+1)) ns
+    std::array<size_t, 40> waitHistogram{};
+    ///@}
+
+    //! @name The arrival skew, i.e. the time from the first to the last arrival of a phase
+    ///@{
+    std::uint64_t totalSkew{0};
+    std::uint64_t maxSkew{0};
+    ///@}
+
+    //! the number of phases each thread was the last to arrive at
+    std::vector<std::pair<std::thread::id, size_t>> lastArrivals;
+};
+
+//! \brief Prints the statistics in a human-readable form.
+std::ostream & operator<<(std::ostream & p_os, const barrierStats & p_stats);
+
+namespace detail
+{
+
+#ifdef CM_BARRIER_STATS
+
+// the statistics of a single barrier, updated concurrently by the participating threads
+class barrierRecorder
+{
+public:
+    using timePoint = std::int64_t;
+
+    static timePoint now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void arrive(timePoint p_time) noexcept
+    {
+        ++m_arrivals;
+        timePoint none = 0;
+        m_phaseStart.compare_exchange_strong(none, p_time, std::memory_order_relaxed);
+    }
+
+    // called by the last thread to arrive, before the others are released
+    void release(timePoint p_time) noexcept;
+
+    void waited(timePoint p_since, bool p_parked) noexcept;
+
+    void dropped() noexcept { ++m_dropouts; }
+
+    barrierStats stats() const;
+
+private:
+    std::atomic<timePoint> m_phaseStart{0};
+    std::atomic_size_t m_arrivals{0};
+    std::atomic_size_t m_dropouts{0};
+    std::atomic_size_t m_spinWaits{0};
+    std::atomic_size_t m_parkedWaits{0};
+    std::atomic<std::uint64_t> m_spinTime{0};
+    std::atomic<std::uint64_t> m_parkedTime{0};
+    std::array<std::atomic_size_t, 40> m_waitHistogram{};
+    // guarded by m_mutex, written by the last arrival of each phase & read by stats() concurrently
+    std::uint64_t m_totalSkew{0};
+    std::uint64_t m_maxSkew{0};
+    mutable std::mutex m_mutex{};
+    std::vector<std::pair<std::thread::id, size_t>> m_lastArrivals;
+};
+
+#else
+
+// compiled out
+class barrierRecorder
+{
+public:
+    using timePoint = int;
+
+    static constexpr timePoint now() noexcept { return 0; }
+    void arrive(timePoint) noexcept {}
+    void release(timePoint) noexcept {}
+    void waited(timePoint, bool) noexcept {}
+    void dropped() noexcept {}
+    barrierStats stats() const { return {}; }
+};
+
+#endif
+
+} // namespace detail
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 //! \brief A simple barrier using a busy wait.
 class SpinLockBarrier
 {
@@ -34,10 +174,15 @@ public:
     //! NOTE: The user is required to ensure on the call-side that the thread no longer arrives at the barrier afterwards.
     void arrive_and_drop() noexcept;
 
+    //! \brief The synchronization statistics, \see barrierStats.
+    barrierStats stats() const;
+
 protected:
+    detail::barrierRecorder m_stats;
     std::atomic_uint m_nThreads;
-    std::atomic_uint m_counter;
-    std::atomic_ulong m_numResets{0};
+    // the arrivals & the waiters' polling on separate lines
+    alignas(cacheLineSize) std::atomic_uint m_counter;
+    alignas(cacheLineSize) std::atomic_ulong m_numResets{0};
 };
 
 //! \brief A synchronization barrier.
@@ -64,25 +209,34 @@ protected:
     mutable std::mutex m_mutex{};
 };
 
+//! \brief The completion step of a BasicFlexBarrier that does nothing; the call is skipped altogether.
+struct noCompletion
+{
+    constexpr std::ptrdiff_t operator()() const noexcept { return -1; }
+};
+
 //! \brief A synchronization barrier with an optional callable that is called after each synchronization.
-//! Implementation of std::experimental::flex_barrier.
+//! Implementation of std::experimental::flex_barrier, with the completion step a template parameter as in std::barrier.
 //! The signature of the callable is std::ptrdiff_t (void), where the return value signifies the new number of participating
-//! threads. If the return is -1, the number remains unchanged.
-class FlexBarrier : public Barrier
+//! threads. If the return is -1, the number remains unchanged. A callable returning void leaves the number unchanged.
+//! The callable is invoked on the last thread to arrive, before the others are released.
+//! BasicFlexBarrier<noCompletion> skips the call; FlexBarrier type-erases the callable, as a std::function.
+template <typename CompletionFn = std::function<std::ptrdiff_t()>>
+class BasicFlexBarrier : public Barrier
 {
 public:
-    using comp_func = std::function<std::ptrdiff_t()>;
+    using comp_func = CompletionFn;
 
-    //! \brief FlexBarrier
+    //! \brief BasicFlexBarrier
     //! \param p_nThreads - The number of participating threads.
-    explicit FlexBarrier(unsigned p_nThreads);
-    //! \brief FlexBarrier
+    explicit BasicFlexBarrier(unsigned p_nThreads);
+    //! \brief BasicFlexBarrier
     //! \param p_nThreads - The number of participating threads.
     //! \param p_func - Custom callable invoked at each synchronization.
-    FlexBarrier(unsigned p_nThreads, comp_func p_func);
-    FlexBarrier(const FlexBarrier &) = delete;
-    FlexBarrier & operator=(const FlexBarrier &) = delete;
-    ~FlexBarrier() = default;
+    BasicFlexBarrier(unsigned p_nThreads, CompletionFn p_func);
+    BasicFlexBarrier(const BasicFlexBarrier &) = delete;
+    BasicFlexBarrier & operator=(const BasicFlexBarrier &) = delete;
+    ~BasicFlexBarrier() = default;
 
     //! \brief The current thread blocks until all \a m_nThreads have arrived at the same point.
     void arrive_and_wait() noexcept;
@@ -94,12 +248,1049 @@ public:
     unsigned numThreads() const { return m_nThreads; }
 
 protected:
-    comp_func m_func;
+    CompletionFn m_func;
 
 private:
     void release() noexcept;
 };
 
+BasicFlexBarrier(unsigned) -> BasicFlexBarrier<noCompletion>;
+template <typename CompletionFn>
+BasicFlexBarrier(unsigned, CompletionFn) -> BasicFlexBarrier<CompletionFn>;
+
+//! \brief The barrier with a type-erased completion step, \see BasicFlexBarrier.
+using FlexBarrier = BasicFlexBarrier<>;
+
+//! \brief A barrier busy-waiting for a bounded number of spins, then parking the thread.
+//! Short phases are thus synchronized at spinning latency, while long ones don't burn the cores.
+//! The threads park on \a m_numResets via std::atomic::wait when available (C++20), else on a condition variable.
+//! With a spin budget of 0 the budget adapts to the recent waits: it grows while the phases complete during the spin
+//! & shrinks while the waiters end up parked.
+class HybridBarrier : public SpinLockBarrier
+{
+public:
+    //! \brief HybridBarrier
+    //! \param p_nThreads - The number of participating threads.
+    //! \param p_spinBudget - The number of spins before parking, 0 for an adaptive budget.
+    explicit HybridBarrier(unsigned p_nThreads, unsigned p_spinBudget = 0);
+    HybridBarrier(const HybridBarrier &) = delete;
+    HybridBarrier & operator=(const HybridBarrier &) = delete;
+    ~HybridBarrier() = default;
+
+    //! \brief The current thread blocks until all \a m_nThreads have arrived at the same point.
+    void arrive_and_wait() noexcept;
+    //! \brief The current thread is counted as having arrived at the barrier, then drops out,
+    //! thereby no longer being counted as participating.
+    //! NOTE: The user is required to ensure on the call-side that the thread no longer arrives at the barrier afterwards.
+    void arrive_and_drop() noexcept;
+
+    //! \brief The current number of spins before parking.
+    unsigned spinBudget() const noexcept;
+
+    static constexpr unsigned minSpins = 64;
+    static constexpr unsigned maxSpins = 1u << 14;
+
+private:
+    void release() noexcept;
+    void park(size_t p_numResets) noexcept;
+
+    unsigned m_fixedBudget;
+    // running average of the spins needed by the waiters
+    alignas(cacheLineSize) std::atomic_uint m_spinEstimate{minSpins};
+    std::atomic_uint m_parked{0};
+#ifndef CM_ATOMIC_WAIT
+    std::condition_variable m_condvar{};
+    std::mutex m_mutex{};
+#endif
+};
+
+//! \brief A combining-tree barrier, scaling to many threads.
+//! The threads arrive at the leaves of a tree of counters, each a cache line of its own, in groups of \a fanIn;
+//! only the last arrival of a group proceeds to the parent. The arrivals are thus spread over many lines & the latency
+//! grows as \f$\mathcal{O}(\log P)\f$. The waiters busy-wait on a single release counter, written once per phase.
+//! Each thread occupies a distinct leaf slot: either passed explicitly as an id in [0, p_nThreads), or assigned on the
+//! first arrival of the thread, in the order of arrival. The two ways must not be mixed on the same barrier: the drawn
+//! slots know nothing of the explicit ids & the two would share a leaf slot unnoticed.
+class TreeBarrier
+{
+public:
+    //! \brief TreeBarrier
+    //! \param p_nThreads - The number of participating threads.
+    //! \param p_fanIn - The number of arrivals combined per counter.
+    explicit TreeBarrier(unsigned p_nThreads, unsigned p_fanIn = 4);
+    TreeBarrier(const TreeBarrier &) = delete;
+    TreeBarrier & operator=(const TreeBarrier &) = delete;
+    ~TreeBarrier() = default;
+
+    //! \brief The current thread blocks until all \a m_nThreads have arrived at the same point.
+    //! The slot of the thread is assigned on its first arrival. NOTE: Not to be mixed with the explicit ids.
+    //! \throws std::range_error if more than p_nThreads distinct threads arrive.
+    void arrive_and_wait();
+    //! \param p_id - The id of the calling thread, in [0, p_nThreads).
+    void arrive_and_wait(unsigned p_id) noexcept;
+    //! \brief The current thread is counted as having arrived at the barrier, then drops out,
+    //! thereby no longer being counted as participating.
+    //! NOTE: The user is required to ensure on the call-side that the thread no longer arrives at the barrier afterwards.
+    //! NOTE: Not to be mixed with the explicit ids.
+    //! \throws std::range_error if more than p_nThreads distinct threads arrive.
+    void arrive_and_drop();
+    //! \param p_id - The id of the calling thread, in [0, p_nThreads).
+    void arrive_and_drop(unsigned p_id) noexcept;
+
+    unsigned numThreads() const { return m_nThreads; }
+
+    //! \brief The synchronization statistics, \see barrierStats.
+    barrierStats stats() const;
+
+private:
+    struct alignas(cacheLineSize) node
+    {
+        std::atomic_uint m_counter{0};
+        // the arrivals still participating, from the threads or the child nodes
+        std::atomic_uint m_expected{0};
+        size_t m_parent{0};
+    };
+
+    // \return whether the phase got released, i.e. this was the last arrival
+    bool arrive(size_t p_node, bool p_drop, detail::barrierRecorder::timePoint p_time) noexcept;
+    // the slot of the calling thread, drawn on its first call; cached per thread for each of the barriers it uses
+    unsigned localId();
+
+    detail::barrierRecorder m_stats;
+    std::atomic_uint m_nThreads;
+    unsigned m_fanIn;
+    std::unique_ptr<node[]> m_nodes;
+    size_t m_root{0};
+    // distinguishes the barriers in the thread-local cache, even at a reused address
+    std::uint64_t m_serial;
+    // the slots available to draw, i.e. the initial participants
+    unsigned m_slots;
+    std::atomic_uint m_drawn{0};
+    // expires with the barrier, letting the thread-local caches drop its entry
+    std::shared_ptr<void> m_alive;
+    alignas(cacheLineSize) std::atomic_ulong m_numResets{0};
+};
+
+namespace detail
+{
+
+//! \brief Lets threads block until a condition holds, e.g. a queue is non-empty.
+//! The waiters spin for a while, then park as in HybridBarrier; the notifiers only pay for a fence unless someone is parked.
+class eventCount
+{
+public:
+    //! \brief Blocks until \a p_ready() returns true; it is retried after each notification.
+    template <typename Pred>
+    void await(Pred && p_ready);
+    //! \brief Wakes up the parked waiters, to be called after making the condition true.
+    void notify() noexcept;
+
+    static constexpr unsigned spinBudget = 1024;
+
+private:
+    void park(unsigned p_epoch) noexcept;
+
+    std::atomic_uint m_epoch{0};
+    std::atomic_uint m_waiters{0};
+#ifndef CM_ATOMIC_WAIT
+    std::condition_variable m_condvar{};
+    std::mutex m_mutex{};
+#endif
+};
+
+} // namespace detail
+
+//! \brief A work-stealing thread pool.
+//! Each worker owns a deque of tasks: it pushes & pops its own at the back, while the idle workers steal from the front
+//! of the others'. The tasks submitted from outside the pool are distributed among the workers round-robin.
+//! The threads waiting on the pool's work (\see TaskGroup::wait, parallel_for, runTeam) execute pending tasks meanwhile.
+class ThreadPool
+{
+public:
+    using task = std::function<void()>;
+
+    //! \brief ThreadPool
+    //! \param p_nThreads - The number of workers, 0 for std::thread::hardware_concurrency().
+    explicit ThreadPool(unsigned p_nThreads = 0);
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+    //! \brief Finishes the pending tasks, then joins the workers.
+    ~ThreadPool();
+
+    //! \brief The number of workers.
+    unsigned size() const noexcept { return m_size; }
+
+    //! \brief Queues a task for execution. The task must not throw.
+    void post(task p_task);
+    //! \brief Queues a callable for execution.
+    //! \return A future for the result, including a thrown exception.
+    template <typename F>
+    auto submit(F && p_func) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+
+    //! \brief Calls \a p_func(i) for all i in [p_first, p_last), in chunks of \a p_grain indices per task.
+    //! Blocks until all the calls have completed, rethrows the first exception thrown.
+    //! \param p_grain - The number of indices per task, 0 for a few chunks per thread.
+    template <typename Index, typename F>
+    void parallel_for(Index p_first, Index p_last, F && p_func, Index p_grain = 0);
+
+    //! \brief Idle workers reserved for a team, \see reserveTeam. Released when run or destroyed.
+    class team
+    {
+    public:
+        team(team && p_other) noexcept;
+        team(const team &) = delete;
+        team & operator=(const team &) = delete;
+        team & operator=(team &&) = delete;
+        ~team();
+
+        //! \brief The number of team members: the reserved workers & the calling thread.
+        unsigned size() const noexcept { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+        //! \brief Runs \a p_func(id) concurrently for all ids in [0, p_n), the calling thread taking id 0.
+        //! All the team members run at the same time on distinct threads, so they can synchronize among themselves,
+        //! e.g. on a FlexBarrier, without oversubscribing the cores. Blocks until all have returned.
+        //! \param p_n - The team size, capped at size(); the workers not needed are released.
+        //! NOTE: \a p_func must not throw. A team can only be run once.
+        template <typename F>
+        void run(unsigned p_n, F && p_func);
+
+    private:
+        friend class ThreadPool;
+        team(ThreadPool & p_pool, std::vector<size_t> p_workers) noexcept;
+
+        void release() noexcept;
+
+        ThreadPool * m_pool;
+        std::vector<size_t> m_workers;
+    };
+
+    //! \brief Reserves up to \a p_n - 1 idle workers for a team of at most \a p_n, the calling thread included.
+    //! The busy workers are skipped, including the calling one, so the team may be smaller, down to the calling thread
+    //! alone. The admission is atomic, so concurrent & nested teams never wait for each other's workers.
+    team reserveTeam(unsigned p_n);
+
+    //! \brief Runs \a p_func(id) concurrently for all ids in [0, n), the calling thread taking id 0, \see team::run.
+    //! \param p_n - The requested team size; only as many threads as reserveTeam() admits take part.
+    //! \return n, the number of members that ran.
+    template <typename F>
+    unsigned runTeam(unsigned p_n, F && p_func);
+
+    //! \brief Executes a single pending task on the calling thread, if there is one.
+    //! \return Whether a task was executed.
+    bool tryRunOne();
+
+private:
+    enum workerState : int
+    {
+        workerIdle,
+        workerBusy,
+        workerReserved
+    };
+
+    struct alignas(cacheLineSize) queue
+    {
+        std::mutex m_mutex;
+        std::deque<task> m_tasks;
+        // idle -> busy by the worker around each task, idle -> reserved by reserveTeam
+        std::atomic_int m_state{workerIdle};
+        // the team member to run once reserved, guarded by the pool's mutex
+        task m_member{};
+        // a reserved worker waits on its own, so that it never swallows the notifications of the queued tasks
+        std::condition_variable m_wake{};
+    };
+
+    void push(size_t p_queue, task p_task);
+    bool pop(size_t p_queue, task & p_task);
+    bool steal(size_t p_queue, task & p_task);
+    void workerLoop(size_t p_queue);
+    // runs the pending tasks until p_done(), parking while there are none
+    template <typename Pred>
+    void helpUntil(Pred && p_done);
+    // the queue of the calling worker, else the next one round-robin
+    size_t localQueue() noexcept;
+
+    // set before the workers start, unlike m_threads
+    unsigned m_size;
+    std::unique_ptr<queue[]> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic_size_t m_next{0};
+    alignas(cacheLineSize) std::atomic_size_t m_pending{0};
+    bool m_stop{false};
+    std::condition_variable m_condvar{};
+    std::mutex m_mutex{};
+    // the threads in helpUntil, notified on a queued task & on the completion of a group's or team's task
+    detail::eventCount m_helpers{};
+
+    friend class TaskGroup;
+};
+
+//! \brief A group of tasks on a ThreadPool that can be waited on together.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool & p_pool) : m_pool(p_pool) {}
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup & operator=(const TaskGroup &) = delete;
+    //! \brief Waits for the outstanding tasks, discarding their exceptions.
+    ~TaskGroup();
+
+    //! \brief Queues a callable as a part of the group.
+    template <typename F>
+    void run(F && p_func);
+    //! \brief Blocks until all the tasks of the group have completed, executing pending tasks meanwhile.
+    //! Rethrows the first exception thrown by a task.
+    void wait();
+
+private:
+    ThreadPool & m_pool;
+    std::atomic_size_t m_pending{0};
+    std::mutex m_mutex{};
+    std::exception_ptr m_exception{};
+};
+
+
+////////////////////////////////////////////////////////////////////////// queues ////////////////////////////////////////////////
+
+
+//! \brief A lock-free bounded single-producer, single-consumer queue.
+//! The producer & the consumer each own an index on a separate cache line, along with a cached copy of the other's,
+//! so they only touch the other cache line when the queue looks full or empty.
+//! \tparam T: has to be default constructible & move assignable.
+template <typename T>
+class SpscQueue
+{
+public:
+    using value_type = T;
+
+    //! \brief SpscQueue
+    //! \param p_capacity - The capacity, rounded up to a power of 2.
+    explicit SpscQueue(size_t p_capacity);
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue & operator=(const SpscQueue &) = delete;
+
+    //! @name Producer
+    ///@{
+    //! \return false if the queue is full, then \a p_value is left untouched.
+    template <typename U>
+    bool try_push(U && p_value);
+    //! \brief Pushes as many of the \a p_n elements from \a p_first as fit, with a single publication.
+    //! \return The number of elements pushed.
+    template <typename InputIt>
+    size_t try_push_n(InputIt p_first, size_t p_n);
+    //! \brief Blocks while the queue is full.
+    template <typename U>
+    void push(U && p_value);
+    ///@}
+
+    //! @name Consumer
+    ///@{
+    //! \return false if the queue is empty.
+    bool try_pop(T & p_value);
+    //! \brief Pops up to \a p_n elements into \a p_out, with a single publication.
+    //! \return The number of elements popped.
+    template <typename OutputIt>
+    size_t try_pop_n(OutputIt p_out, size_t p_n);
+    //! \brief Blocks while the queue is empty.
+    T pop();
+    ///@}
+
+    size_t capacity() const noexcept { return m_mask + 1; }
+    //! \brief The approximate number of elements.
+    size_t size() const noexcept { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+    bool empty() const noexcept { return size() == 0; }
+
+private:
+    size_t m_mask;
+    std::unique_ptr<T[]> m_data;
+
+    // the consumer's
+    alignas(cacheLineSize) std::atomic_size_t m_head{0};
+    size_t m_tailCache{0};
+
+    // the producer's
+    alignas(cacheLineSize) std::atomic_size_t m_tail{0};
+    size_t m_headCache{0};
+
+    alignas(cacheLineSize) detail::eventCount m_notEmpty;
+    detail::eventCount m_notFull;
+};
+
+//! \brief A lock-free bounded multi-producer, multi-consumer queue.
+//! Each slot carries a sequence number telling the producers & consumers whose turn it is (D. Vyukov's design),
+//! so a push or pop costs a single CAS on the contended index.
+//! \tparam T: has to be default constructible & move assignable.
+template <typename T>
+class MpmcQueue
+{
+public:
+    using value_type = T;
+
+    //! \brief MpmcQueue
+    //! \param p_capacity - The capacity, rounded up to a power of 2, at least 2.
+    explicit MpmcQueue(size_t p_capacity);
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue & operator=(const MpmcQueue &) = delete;
+
+    //! \return false if the queue is full, then \a p_value is left untouched.
+    template <typename U>
+    bool try_push(U && p_value);
+    //! \brief Pushes as many of the \a p_n elements from \a p_first as fit.
+    //! \return The number of elements pushed.
+    template <typename InputIt>
+    size_t try_push_n(InputIt p_first, size_t p_n);
+    //! \brief Blocks while the queue is full.
+    template <typename U>
+    void push(U && p_value);
+
+    //! \return false if the queue is empty.
+    bool try_pop(T & p_value);
+    //! \brief Pops up to \a p_n elements into \a p_out.
+    //! \return The number of elements popped.
+    template <typename OutputIt>
+    size_t try_pop_n(OutputIt p_out, size_t p_n);
+    //! \brief Blocks while the queue is empty.
+    T pop();
+
+    size_t capacity() const noexcept { return m_mask + 1; }
+    //! \brief The approximate number of elements.
+    size_t size() const noexcept;
+    bool empty() const noexcept { return size() == 0; }
+
+private:
+    struct slot
+    {
+        std::atomic_size_t m_seq;
+        T m_value;
+    };
+
+    size_t m_mask;
+    std::unique_ptr<slot[]> m_slots;
+
+    alignas(cacheLineSize) std::atomic_size_t m_head{0};
+    alignas(cacheLineSize) std::atomic_size_t m_tail{0};
+
+    alignas(cacheLineSize) detail::eventCount m_notEmpty;
+    detail::eventCount m_notFull;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename CompletionFn>
+BasicFlexBarrier<CompletionFn>::BasicFlexBarrier(unsigned p_nThreads) : Barrier(p_nThreads), m_func(noCompletion{})
+{
+}
+
+template <typename CompletionFn>
+BasicFlexBarrier<CompletionFn>::BasicFlexBarrier(unsigned p_nThreads, CompletionFn p_func)
+    : Barrier(p_nThreads), m_func(std::move(p_func))
+{
+}
+
+template <typename CompletionFn>
+void BasicFlexBarrier<CompletionFn>::arrive_and_wait() noexcept
+{
+    if (m_nThreads == 0)
+    {
+        return;
+    }
+    CM_PROFILE_TIMER("BasicFlexBarrier::arrive_and_wait");
+
+    size_t numResets = m_numResets;
+    auto arrival = m_stats.now();
+    m_stats.arrive(arrival);
+
+    std::unique_lock lk(m_mutex, std::defer_lock);
+
+    if (--m_counter == 0)
+    {
+        m_stats.release(arrival);
+        release();
+    }
+    else
+    {
+        lk.lock();
+        m_condvar.wait(lk, [this, numResets]() { return numResets != m_numResets; });
+        lk.unlock();
+        m_stats.waited(arrival, true);
+    }
+}
+
+template <typename CompletionFn>
+void BasicFlexBarrier<CompletionFn>::arrive_and_drop() noexcept
+{
+    if (m_nThreads == 0)
+    {
+        return;
+    }
+
+    --m_nThreads;
+    auto arrival = m_stats.now();
+    m_stats.dropped();
+    m_stats.arrive(arrival);
+
+    if (--m_counter == 0)
+    {
+        m_stats.release(arrival);
+        release();
+    }
+}
+
+template <typename CompletionFn>
+void BasicFlexBarrier<CompletionFn>::release() noexcept
+{
+    if constexpr (!std::is_same_v<CompletionFn, noCompletion>)
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<CompletionFn &>>)
+        {
+            m_func();
+        }
+        else
+        {
+            std::ptrdiff_t ret = m_func();
+            if (ret >= 0)
+            {
+                m_nThreads = static_cast<unsigned>(ret);
+            }
+        }
+    }
+    m_counter = m_nThreads.load();
+    {
+        std::lock_guard lk(m_mutex);
+        m_numResets++;
+    }
+    m_condvar.notify_all();
+}
+
+template <typename F>
+auto ThreadPool::submit(F && p_func) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+{
+    using Ret = std::invoke_result_t<std::decay_t<F>>;
+
+    // std::function requires a copyable callable
+    auto packaged = std::make_shared<std::packaged_task<Ret()>>(std::forward<F>(p_func));
+    std::future<Ret> ret = packaged->get_future();
+    post([packaged]() { (*packaged)(); });
+
+    return ret;
+}
+
+template <typename Index, typename F>
+void ThreadPool::parallel_for(Index p_first, Index p_last, F && p_func, Index p_grain)
+{
+    if (!(p_first < p_last))
+    {
+        return;
+    }
+
+    const Index count = p_last - p_first;
+    if (p_grain <= Index{0})
+    {
+        p_grain = std::max(Index{1}, static_cast<Index>(count / (8 * (size() + 1))));
+    }
+
+    TaskGroup group(*this);
+    for (Index first = p_first; first < p_last;)
+    {
+        Index last = p_last - first > p_grain ? first + p_grain : p_last;
+        group.run([&p_func, first, last]() {
+            for (Index i = first; i != last; ++i)
+            {
+                p_func(i);
+            }
+        });
+        first = last;
+    }
+    group.wait();
+}
+
+template <typename F>
+void ThreadPool::team::run(unsigned p_n, F && p_func)
+{
+    p_n = std::min(p_n, size());
+    if (p_n == 0)
+    {
+        release();
+        return;
+    }
+
+    // one member per reserved worker, the rest handed back
+    std::atomic_uint remaining{p_n - 1};
+    {
+        std::lock_guard lk(m_pool->m_mutex);
+        for (unsigned id = 1; id < p_n; ++id)
+        {
+            m_pool->m_queues[m_workers[id - 1]].m_member = [&p_func, &remaining, pool = m_pool, id]() {
+                p_func(id);
+                --remaining;
+                pool->m_helpers.notify();
+            };
+        }
+    }
+    for (unsigned id = 1; id < p_n; ++id)
+    {
+        m_pool->m_queues[m_workers[id - 1]].m_wake.notify_one();
+    }
+    // the members still parked as idle workers
+    m_pool->m_condvar.notify_all();
+    m_workers.erase(m_workers.begin(), m_workers.begin() + (p_n - 1));
+    release();
+
+    p_func(0u);
+
+    m_pool->helpUntil([&remaining]() { return remaining == 0; });
+}
+
+template <typename Pred>
+void ThreadPool::helpUntil(Pred && p_done)
+{
+    while (!p_done())
+    {
+        if (!tryRunOne())
+        {
+            m_helpers.await([this, &p_done]() { return p_done() || m_pending != 0; });
+        }
+    }
+}
+
+template <typename F>
+unsigned ThreadPool::runTeam(unsigned p_n, F && p_func)
+{
+    team members = reserveTeam(p_n);
+    const unsigned ret = std::min(p_n, members.size());
+    members.run(ret, p_func);
+    return ret;
+}
+
+template <typename F>
+void TaskGroup::run(F && p_func)
+{
+    ++m_pending;
+    m_pool.post([this, func = std::forward<F>(p_func)]() mutable {
+        try
+        {
+            func();
+        }
+        catch (...)
+        {
+            std::lock_guard lk(m_mutex);
+            if (!m_exception)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+        // the group may be gone right after
+        ThreadPool & pool = m_pool;
+        --m_pending;
+        pool.m_helpers.notify();
+    });
+}
+
+// queues
+
+namespace detail
+{
+
+template <typename Pred>
+void eventCount::await(Pred && p_ready)
+{
+    for (unsigned spins = 0; spins < spinBudget; ++spins)
+    {
+        if (p_ready())
+        {
+            return;
+        }
+        cpuRelax();
+    }
+
+    for (;;)
+    {
+        // registered before the retry, so that either the retry succeeds or the notifier sees the waiter
+        ++m_waiters;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        unsigned epoch = m_epoch.load();
+        if (p_ready())
+        {
+            --m_waiters;
+            return;
+        }
+        park(epoch);
+        --m_waiters;
+    }
+}
+
+inline void eventCount::notify() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+#ifdef CM_ATOMIC_WAIT
+    m_epoch++;
+    m_epoch.notify_all();
+#else
+    {
+        std::lock_guard lk(m_mutex);
+        m_epoch++;
+    }
+    m_condvar.notify_all();
+#endif
+}
+
+inline void eventCount::park(unsigned p_epoch) noexcept
+{
+#ifdef CM_ATOMIC_WAIT
+    m_epoch.wait(p_epoch);
+#else
+    std::unique_lock lk(m_mutex);
+    m_condvar.wait(lk, [this, p_epoch]() { return p_epoch != m_epoch; });
+#endif
+}
+
+// the next power of 2 not below p_n & at least p_min
+constexpr size_t queueCapacity(size_t p_n, size_t p_min = 1) noexcept
+{
+    size_t ret = p_min;
+    while (ret < p_n)
+    {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+} // namespace detail
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t p_capacity)
+    : m_mask(detail::queueCapacity(p_capacity) - 1), m_data(std::make_unique<T[]>(m_mask + 1))
+{
+}
+
+template <typename T>
+template <typename U>
+bool SpscQueue<T>::try_push(U && p_value)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_headCache > m_mask)
+    {
+        m_headCache = m_head.load(std::memory_order_acquire);
+        if (tail - m_headCache > m_mask)
+        {
+            return false;
+        }
+    }
+
+    m_data[tail & m_mask] = std::forward<U>(p_value);
+    m_tail.store(tail + 1, std::memory_order_release);
+    m_notEmpty.notify();
+
+    return true;
+}
+
+template <typename T>
+template <typename InputIt>
+size_t SpscQueue<T>::try_push_n(InputIt p_first, size_t p_n)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (capacity() - (tail - m_headCache) < p_n)
+    {
+        m_headCache = m_head.load(std::memory_order_acquire);
+    }
+
+    size_t n = std::min(p_n, capacity() - (tail - m_headCache));
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; ++i, ++p_first)
+    {
+        m_data[(tail + i) & m_mask] = *p_first;
+    }
+    m_tail.store(tail + n, std::memory_order_release);
+    m_notEmpty.notify();
+
+    return n;
+}
+
+template <typename T>
+template <typename U>
+void SpscQueue<T>::push(U && p_value)
+{
+    // a failed attempt leaves the value untouched
+    m_notFull.await([this, &p_value]() { return try_push(std::forward<U>(p_value)); });
+}
+
+template <typename T>
+bool SpscQueue<T>::try_pop(T & p_value)
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tailCache)
+    {
+        m_tailCache = m_tail.load(std::memory_order_acquire);
+        if (head == m_tailCache)
+        {
+            return false;
+        }
+    }
+
+    p_value = std::move(m_data[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_release);
+    m_notFull.notify();
+
+    return true;
+}
+
+template <typename T>
+template <typename OutputIt>
+size_t SpscQueue<T>::try_pop_n(OutputIt p_out, size_t p_n)
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (m_tailCache - head < p_n)
+    {
+        m_tailCache = m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t n = std::min(p_n, m_tailCache - head);
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; ++i, ++p_out)
+    {
+        *p_out = std::move(m_data[(head + i) & m_mask]);
+    }
+    m_head.store(head + n, std::memory_order_release);
+    m_notFull.notify();
+
+    return n;
+}
+
+template <typename T>
+T SpscQueue<T>::pop()
+{
+    T ret;
+    m_notEmpty.await([this, &ret]() { return try_pop(ret); });
+    return ret;
+}
+
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t p_capacity)
+    : m_mask(detail::queueCapacity(p_capacity, 2) - 1), m_slots(std::make_unique<slot[]>(m_mask + 1))
+{
+    for (size_t i = 0; i <= m_mask; ++i)
+    {
+        m_slots[i].m_seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+template <typename U>
+bool MpmcQueue<T>::try_push(U && p_value)
+{
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    slot * current;
+
+    for (;;)
+    {
+        current = &m_slots[pos & m_mask];
+        size_t seq = current->m_seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+
+        if (diff == 0)
+        {
+            // the slot is free in this lap
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // not yet consumed in the previous lap
+            return false;
+        }
+        else
+        {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    current->m_value = std::forward<U>(p_value);
+    current->m_seq.store(pos + 1, std::memory_order_release);
+    m_notEmpty.notify();
+
+    return true;
+}
+
+template <typename T>
+template <typename InputIt>
+size_t MpmcQueue<T>::try_push_n(InputIt p_first, size_t p_n)
+{
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    size_t n = 0;
+
+    while (p_n != 0)
+    {
+        // the run of slots free in this lap; each stays free until its position is claimed, i.e. by the CAS below
+        n = 0;
+        size_t seq = 0;
+        while (n < p_n && (seq = m_slots[(pos + n) & m_mask].m_seq.load(std::memory_order_acquire)) == pos + n)
+        {
+            ++n;
+        }
+
+        if (n != 0)
+        {
+            if (m_tail.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (static_cast<std::ptrdiff_t>(seq - pos) < 0)
+        {
+            // not yet consumed in the previous lap
+            return 0;
+        }
+        else
+        {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i, ++p_first)
+    {
+        m_slots[(pos + i) & m_mask].m_value = *p_first;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        m_slots[(pos + i) & m_mask].m_seq.store(pos + i + 1, std::memory_order_release);
+    }
+    if (n != 0)
+    {
+        m_notEmpty.notify();
+    }
+
+    return n;
+}
+
+template <typename T>
+template <typename U>
+void MpmcQueue<T>::push(U && p_value)
+{
+    m_notFull.await([this, &p_value]() { return try_push(std::forward<U>(p_value)); });
+}
+
+template <typename T>
+bool MpmcQueue<T>::try_pop(T & p_value)
+{
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    slot * current;
+
+    for (;;)
+    {
+        current = &m_slots[pos & m_mask];
+        size_t seq = current->m_seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+
+        if (diff == 0)
+        {
+            // the slot was filled in this lap
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    p_value = std::move(current->m_value);
+    // free for the next lap
+    current->m_seq.store(pos + m_mask + 1, std::memory_order_release);
+    m_notFull.notify();
+
+    return true;
+}
+
+template <typename T>
+template <typename OutputIt>
+size_t MpmcQueue<T>::try_pop_n(OutputIt p_out, size_t p_n)
+{
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    size_t n = 0;
+
+    while (p_n != 0)
+    {
+        // the run of slots filled in this lap; each stays filled until its position is claimed, i.e. by the CAS below
+        n = 0;
+        size_t seq = 0;
+        while (n < p_n && (seq = m_slots[(pos + n) & m_mask].m_seq.load(std::memory_order_acquire)) == pos + n + 1)
+        {
+            ++n;
+        }
+
+        if (n != 0)
+        {
+            if (m_head.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i, ++p_out)
+    {
+        slot & current = m_slots[(pos + i) & m_mask];
+        *p_out = std::move(current.m_value);
+        // free for the next lap
+        current.m_seq.store(pos + i + m_mask + 1, std::memory_order_release);
+    }
+    if (n != 0)
+    {
+        m_notFull.notify();
+    }
+
+    return n;
+}
+
+template <typename T>
+T MpmcQueue<T>::pop()
+{
+    T ret;
+    m_notEmpty.await([this, &ret]() { return try_pop(ret); });
+    return ret;
+}
+
+template <typename T>
+size_t MpmcQueue<T>::size() const noexcept
+{
+    size_t head = m_head.load(std::memory_order_acquire);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+}
+
 } // namespace cm
 
 #endif // CM_THREAD_H
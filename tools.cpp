@@ -0,0 +1,361 @@
+/** \file tools.cpp
+ * \author Andrej Leban
+ * \date 10/2026
+ */
+
+#include "tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+
+namespace cm
+{
+namespace prof
+{
+
+namespace
+{
+
+//! \brief A trace event of a finished thread.
+struct retiredEvent
+{
+    detail::traceEvent event;
+    unsigned id;
+};
+
+//! \brief The names & the data of the running threads, with the totals of the finished ones.
+struct registry
+{
+    std::mutex mutex;
+    std::vector<const char *> counters;
+    std::vector<const char *> histograms;
+    // a deque, so the thread data never moves
+    std::deque<detail::threadData> threads;
+    // the zeroed slots of the finished threads, to be reused
+    std::vector<detail::threadData *> free;
+    // the counters & histograms merged from the finished threads
+    detail::threadData retired;
+    // the last traceCapacity events of the finished threads, a ring as the one of a thread
+    std::unique_ptr<retiredEvent[]> retiredTrace;
+    std::uint64_t retiredTraced{0};
+    unsigned nextId{0};
+};
+
+registry & instance()
+{
+    // leaked, so that it stays valid for the threads finishing after the static destructors
+    static registry * ret = new registry;
+    return *ret;
+}
+
+size_t registerName(std::vector<const char *> & p_names, const char * p_name, size_t p_max)
+{
+    auto it = std::find_if(p_names.begin(), p_names.end(), [p_name](const char * name) { return std::strcmp(name, p_name) == 0; });
+    if (it != p_names.end())
+    {
+        return static_cast<size_t>(it - p_names.begin());
+    }
+    if (p_names.size() == p_max)
+    {
+        throw std::range_error("prof: too many names registered");
+    }
+
+    p_names.push_back(p_name);
+    return p_names.size() - 1;
+}
+
+void zero(detail::histogramSlots & p_slots)
+{
+    p_slots.count.store(0, std::memory_order_relaxed);
+    p_slots.sum.store(0, std::memory_order_relaxed);
+    p_slots.min.store(0, std::memory_order_relaxed);
+    p_slots.max.store(0, std::memory_order_relaxed);
+    for (auto & bucket : p_slots.buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void merge(detail::histogramSlots & p_into, const detail::histogramSlots & p_from)
+{
+    std::uint64_t count = p_from.count.load(std::memory_order_relaxed);
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::uint64_t min = p_from.min.load(std::memory_order_relaxed);
+    if (p_into.count.load(std::memory_order_relaxed) == 0 || min < p_into.min.load(std::memory_order_relaxed))
+    {
+        p_into.min.store(min, std::memory_order_relaxed);
+    }
+    p_into.max.store(std::max(p_into.max.load(std::memory_order_relaxed), p_from.max.load(std::memory_order_relaxed)),
+                     std::memory_order_relaxed);
+    detail::bump(p_into.count, count);
+    detail::bump(p_into.sum, p_from.sum.load(std::memory_order_relaxed));
+    for (size_t b = 0; b < histogramBuckets; ++b)
+    {
+        detail::bump(p_into.buckets[b], p_from.buckets[b].load(std::memory_order_relaxed));
+    }
+}
+
+//! \brief Calls \p p_func on the totals of the finished threads, then on the slot of each thread.
+template <typename F>
+void forEachData(registry & p_reg, F && p_func)
+{
+    p_func(p_reg.retired);
+    for (auto & thread : p_reg.threads)
+    {
+        p_func(thread);
+    }
+}
+
+//! \brief Merges the data of the finishing thread into the totals & frees its slot.
+void retire(detail::threadData & p_data)
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+
+    for (size_t i = 0; i < maxCounters; ++i)
+    {
+        detail::bump(reg.retired.counters[i], p_data.counters[i].load(std::memory_order_relaxed));
+        p_data.counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < maxHistograms; ++i)
+    {
+        merge(reg.retired.histograms[i], p_data.histograms[i]);
+        zero(p_data.histograms[i]);
+    }
+
+    if (p_data.trace)
+    {
+        if (!reg.retiredTrace)
+        {
+            reg.retiredTrace = std::make_unique<retiredEvent[]>(traceCapacity);
+        }
+        std::uint64_t begin = p_data.traced > traceCapacity ? p_data.traced - traceCapacity : 0;
+        for (std::uint64_t i = begin; i < p_data.traced; ++i)
+        {
+            reg.retiredTrace[reg.retiredTraced++ % traceCapacity] = {p_data.trace[i % traceCapacity], p_data.id};
+        }
+        // the buffer stays with the slot
+        p_data.traced = 0;
+    }
+
+    reg.free.push_back(&p_data);
+}
+
+//! \brief Retires the slot of the thread on its exit.
+struct retirer
+{
+    ~retirer()
+    {
+        if (detail::tl_data)
+        {
+            retire(*detail::tl_data);
+            detail::tl_data = nullptr;
+        }
+    }
+};
+
+//! \brief Nanoseconds printed as microseconds, exactly.
+struct micros
+{
+    std::uint64_t ns;
+};
+
+std::ostream & operator<<(std::ostream & p_os, micros p_value)
+{
+    char fraction[4] = {char('0' + p_value.ns / 100 % 10), char('0' + p_value.ns / 10 % 10), char('0' + p_value.ns % 10), 0};
+    return p_os << p_value.ns / 1000 << '.' << fraction;
+}
+
+} // namespace
+
+
+std::uint64_t steadyClock::now() noexcept
+{
+    auto since = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since).count());
+}
+
+std::uint64_t histogramData::quantile(double q) const noexcept
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count - 1));
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < histogramBuckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen > rank)
+        {
+            // the upper bound of the bucket, but never above the largest value seen
+            return i == 0 ? 0 : std::min(max, i == 64 ? max : (std::uint64_t{1} << i) - 1);
+        }
+    }
+    return max;
+}
+
+std::ostream & operator<<(std::ostream & p_os, const profileData & p_data)
+{
+    for (const auto & [name, value] : p_data.counters)
+    {
+        p_os << name << ": " << value << '\n';
+    }
+    for (const auto & [name, hist] : p_data.histograms)
+    {
+        p_os << name << ": count " << hist.count << ", mean "
+             << (hist.count ? static_cast<double>(hist.sum) / static_cast<double>(hist.count) : 0.0) << ", min " << hist.min
+             << ", p50 " << hist.quantile(0.5) << ", p99 " << hist.quantile(0.99) << ", max " << hist.max << '\n';
+    }
+    return p_os;
+}
+
+profileData collect()
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+
+    profileData ret;
+    for (size_t i = 0; i < reg.counters.size(); ++i)
+    {
+        std::uint64_t value = 0;
+        forEachData(reg, [&value, i](const detail::threadData & p_data) {
+            value += p_data.counters[i].load(std::memory_order_relaxed);
+        });
+        ret.counters.emplace_back(reg.counters[i], value);
+    }
+
+    for (size_t i = 0; i < reg.histograms.size(); ++i)
+    {
+        histogramData hist;
+        forEachData(reg, [&hist, i](const detail::threadData & p_data) {
+            const detail::histogramSlots & slots = p_data.histograms[i];
+            std::uint64_t count = slots.count.load(std::memory_order_relaxed);
+            if (count == 0)
+            {
+                return;
+            }
+
+            std::uint64_t min = slots.min.load(std::memory_order_relaxed);
+            hist.min = hist.count ? std::min(hist.min, min) : min;
+            hist.max = std::max(hist.max, slots.max.load(std::memory_order_relaxed));
+            hist.count += count;
+            hist.sum += slots.sum.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < histogramBuckets; ++b)
+            {
+                hist.buckets[b] += slots.buckets[b].load(std::memory_order_relaxed);
+            }
+        });
+        ret.histograms.emplace_back(reg.histograms[i], hist);
+    }
+
+    return ret;
+}
+
+void reset()
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+
+    forEachData(reg, [](detail::threadData & p_data) {
+        for (auto & value : p_data.counters)
+        {
+            value.store(0, std::memory_order_relaxed);
+        }
+        for (auto & slots : p_data.histograms)
+        {
+            zero(slots);
+        }
+        p_data.traced = 0;
+    });
+    reg.retiredTraced = 0;
+}
+
+void writeTrace(std::ostream & p_os)
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+
+    // complete events, in microseconds
+    p_os << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto & thread : reg.threads)
+    {
+        if (!thread.trace)
+        {
+            continue;
+        }
+
+        std::uint64_t begin = thread.traced > traceCapacity ? thread.traced - traceCapacity : 0;
+        for (std::uint64_t i = begin; i < thread.traced; ++i)
+        {
+            const detail::traceEvent & event = thread.trace[i % traceCapacity];
+            p_os << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.id
+                 << ",\"ts\":" << micros{event.start} << ",\"dur\":" << micros{event.end - event.start} << '}';
+            first = false;
+        }
+    }
+
+    std::uint64_t begin = reg.retiredTraced > traceCapacity ? reg.retiredTraced - traceCapacity : 0;
+    for (std::uint64_t i = begin; i < reg.retiredTraced; ++i)
+    {
+        const retiredEvent & retired = reg.retiredTrace[i % traceCapacity];
+        const detail::traceEvent & event = retired.event;
+        p_os << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << retired.id
+             << ",\"ts\":" << micros{event.start} << ",\"dur\":" << micros{event.end - event.start} << '}';
+        first = false;
+    }
+    p_os << "\n]}\n";
+}
+
+
+size_t detail::registerCounter(const char * p_name)
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+    return registerName(reg.counters, p_name, maxCounters);
+}
+
+size_t detail::registerHistogram(const char * p_name)
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+    return registerName(reg.histograms, p_name, maxHistograms);
+}
+
+detail::threadData & detail::registerThread()
+{
+    registry & reg = instance();
+    std::lock_guard lk(reg.mutex);
+
+    threadData * ret;
+    if (reg.free.empty())
+    {
+        ret = &reg.threads.emplace_back();
+    }
+    else
+    {
+        ret = reg.free.back();
+        reg.free.pop_back();
+    }
+    // a fresh id, the trace of the previous owner is kept under its own
+    ret->id = reg.nextId++;
+
+    // constructed on the first use by the thread, destroyed on its exit
+    static thread_local retirer tl_retirer;
+    static_cast<void>(tl_retirer);
+    return *ret;
+}
+
+} // namespace prof
+} // namespace cm
@@ -8,7 +8,28 @@
 #ifndef TOOLS_H
 #define TOOLS_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CM_PROFILING_TSC
+#endif
+
+// the instrumentation is compiled in with the testing macros or on its own, via the PROFILING option
+#if defined(CM_PROFILING) || defined(TESTING)
+#define CM_PROFILING_ENABLED 1
+#else
+#define CM_PROFILING_ENABLED 0
+#endif
 
 namespace cm
 {
@@ -26,5 +47,312 @@ inline void compiler_version()
 }
 
 
+//! \brief Low-overhead instrumentation: counters, histograms, scoped timers & trace regions.
+//! The measurements go to thread-local slots without any synchronization & are only merged by collect().
+//! Without CM_PROFILING or TESTING all the classes are empty & the macros below expand to nothing, so the
+//! instrumentation can stay in the production code.
+//! NOTE: changes the inline code, the clients have to be built with the same setting as the library.
+namespace prof
+{
+
+//! \brief Whether the instrumentation is compiled in.
+constexpr bool enabled = CM_PROFILING_ENABLED;
+
+//! @name Clocks
+///@{
+//! \brief The steady clock, in nanoseconds.
+struct steadyClock
+{
+    static std::uint64_t now() noexcept;
+};
+
+//! \brief The time stamp counter, in cycles; cheaper to read but not serializing.
+//! Falls back on steadyClock on platforms without one.
+struct tscClock
+{
+    static std::uint64_t now() noexcept;
+};
+///@}
+
+constexpr size_t maxCounters = 256;
+constexpr size_t maxHistograms = 64;
+//! \brief Bucket i holds the values in [2^(i-1), 2^i), bucket 0 the zeros.
+constexpr size_t histogramBuckets = 65;
+//! \brief The number of trace events kept per thread, the older ones get overwritten.
+constexpr size_t traceCapacity = 1 << 14;
+
+//! \brief A histogram merged over the threads.
+struct histogramData
+{
+    std::uint64_t count{0};
+    std::uint64_t sum{0};
+    std::uint64_t min{0};
+    std::uint64_t max{0};
+    std::array<std::uint64_t, histogramBuckets> buckets{};
+
+    //! \brief An estimate of the \p q quantile, the upper bound of the bucket it falls in.
+    std::uint64_t quantile(double q) const noexcept;
+};
+
+//! \brief The counters & histograms merged over the threads, by name.
+struct profileData
+{
+    std::vector<std::pair<std::string, std::uint64_t>> counters;
+    std::vector<std::pair<std::string, histogramData>> histograms;
+};
+
+std::ostream & operator<<(std::ostream & p_os, const profileData & p_data);
+
+//! \brief Merges the counters & histograms of all the threads, including the finished ones.
+//! Safe to call while the threads are measuring, though the result is then not a consistent cut.
+profileData collect();
+//! \brief Zeroes all the counters, histograms & traces, the registrations are kept.
+//! NOTE: only while no other thread is measuring.
+void reset();
+//! \brief Writes the trace regions of all the threads in the Chrome trace event format (chrome://tracing, Perfetto).
+//! The timestamps are those of steadyClock.
+//! NOTE: only while no other thread is measuring.
+void writeTrace(std::ostream & p_os);
+
+namespace detail
+{
+struct traceEvent
+{
+    const char * name;
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+struct histogramSlots
+{
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> min;
+    std::atomic<std::uint64_t> max;
+    std::array<std::atomic<std::uint64_t>, histogramBuckets> buckets;
+};
+
+//! \brief The slots of a single thread. Only the owner writes, so relaxed loads & stores suffice.
+struct threadData
+{
+    std::array<std::atomic<std::uint64_t>, maxCounters> counters{};
+    std::array<histogramSlots, maxHistograms> histograms{};
+    // allocated on the first trace region
+    std::unique_ptr<traceEvent[]> trace;
+    std::uint64_t traced{0};
+    unsigned id{0};
+};
+
+//! \brief Registers \p p_name, returning the id shared by all the registrations of the same name.
+//! \throws std::range_error if there are too many names.
+size_t registerCounter(const char * p_name);
+size_t registerHistogram(const char * p_name);
+//! \brief Registers the calling thread, reusing the slot of a finished one if there is any.
+//! When the thread finishes, its counters & histograms are merged into the totals & the slot is freed.
+threadData & registerThread();
+
+// reset on the thread exit, so that a late measurement registers anew rather than writing to a freed slot
+inline thread_local threadData * tl_data = nullptr;
+
+inline threadData & local()
+{
+    if (!tl_data)
+    {
+        tl_data = &registerThread();
+    }
+    return *tl_data;
+}
+
+inline void bump(std::atomic<std::uint64_t> & p_slot, std::uint64_t p_value) noexcept
+{
+    p_slot.store(p_slot.load(std::memory_order_relaxed) + p_value, std::memory_order_relaxed);
+}
+} // namespace detail
+
+#if CM_PROFILING_ENABLED
+
+//! \brief A named counter, summed over the threads.
+//! Meant as a static, \see CM_PROFILE_COUNT.
+class counter
+{
+public:
+    explicit counter(const char * p_name) : m_id(detail::registerCounter(p_name)) {}
+
+    void add(std::uint64_t p_value = 1) const { detail::bump(detail::local().counters[m_id], p_value); }
+
+private:
+    size_t m_id;
+};
+
+//! \brief A named histogram of log2 buckets, merged over the threads.
+//! Meant as a static, \see CM_PROFILE_TIMER.
+class histogram
+{
+public:
+    explicit histogram(const char * p_name) : m_id(detail::registerHistogram(p_name)) {}
+
+    void record(std::uint64_t p_value) const;
+
+private:
+    size_t m_id;
+};
+
+//! \brief Records the lifetime of the scope into a histogram, in the units of \p Clock.
+template <typename Clock = steadyClock>
+class scopedTimer
+{
+public:
+    explicit scopedTimer(const histogram & p_histogram) : m_histogram(p_histogram), m_start(Clock::now()) {}
+    scopedTimer(const scopedTimer &) = delete;
+    scopedTimer & operator=(const scopedTimer &) = delete;
+    ~scopedTimer() { m_histogram.record(Clock::now() - m_start); }
+
+private:
+    const histogram & m_histogram;
+    std::uint64_t m_start;
+};
+
+//! \brief Records the lifetime of the scope as a trace event, \see writeTrace.
+//! \p p_name has to outlive the trace, e.g. a string literal.
+class traceRegion
+{
+public:
+    explicit traceRegion(const char * p_name) : m_name(p_name), m_start(steadyClock::now()) {}
+    traceRegion(const traceRegion &) = delete;
+    traceRegion & operator=(const traceRegion &) = delete;
+    ~traceRegion();
+
+private:
+    const char * m_name;
+    std::uint64_t m_start;
+};
+
+#else
+
+class counter
+{
+public:
+    explicit counter(const char *) noexcept {}
+    void add(std::uint64_t = 1) const noexcept {}
+};
+
+class histogram
+{
+public:
+    explicit histogram(const char *) noexcept {}
+    void record(std::uint64_t) const noexcept {}
+};
+
+template <typename Clock = steadyClock>
+class scopedTimer
+{
+public:
+    explicit scopedTimer(const histogram &) noexcept {}
+    scopedTimer(const scopedTimer &) = delete;
+    scopedTimer & operator=(const scopedTimer &) = delete;
+};
+
+class traceRegion
+{
+public:
+    explicit traceRegion(const char *) noexcept {}
+    traceRegion(const traceRegion &) = delete;
+    traceRegion & operator=(const traceRegion &) = delete;
+};
+
+#endif // CM_PROFILING_ENABLED
+
+} // namespace prof
+
 } // namespace cm
+
+//! @name Instrumentation macros
+//! The names have to be string literals. Expand to nothing without CM_PROFILING or TESTING.
+///@{
+#if CM_PROFILING_ENABLED
+#define CM_PROFILE_CONCAT_(a, b) a##b
+#define CM_PROFILE_CONCAT(a, b) CM_PROFILE_CONCAT_(a, b)
+
+//! \brief Adds \p value to the counter \p name.
+#define CM_PROFILE_COUNT(name, value)                                                                                            \
+    do                                                                                                                           \
+    {                                                                                                                            \
+        static const ::cm::prof::counter cm_profile_counter(name);                                                               \
+        cm_profile_counter.add(value);                                                                                           \
+    } while (0)
+//! \brief Records the duration of the enclosing scope into the histogram \p name, in nanoseconds.
+#define CM_PROFILE_TIMER(name)                                                                                                   \
+    static const ::cm::prof::histogram CM_PROFILE_CONCAT(cm_profile_histogram, __LINE__)(name);                                 \
+    const ::cm::prof::scopedTimer<> CM_PROFILE_CONCAT(cm_profile_timer, __LINE__)(CM_PROFILE_CONCAT(cm_profile_histogram, __LINE__))
+//! \brief Records the enclosing scope as the trace region \p name.
+#define CM_PROFILE_REGION(name) const ::cm::prof::traceRegion CM_PROFILE_CONCAT(cm_profile_region, __LINE__)(name)
+//! \brief Both CM_PROFILE_TIMER & CM_PROFILE_REGION.
+#define CM_PROFILE_SCOPE(name)                                                                                                   \
+    CM_PROFILE_TIMER(name);                                                                                                      \
+    CM_PROFILE_REGION(name)
+#else
+#define CM_PROFILE_COUNT(name, value) static_cast<void>(0)
+#define CM_PROFILE_TIMER(name) static_cast<void>(0)
+#define CM_PROFILE_REGION(name) static_cast<void>(0)
+#define CM_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
+///@}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace cm
+{
+namespace prof
+{
+
+inline std::uint64_t tscClock::now() noexcept
+{
+#ifdef CM_PROFILING_TSC
+    return __rdtsc();
+#else
+    return steadyClock::now();
+#endif
+}
+
+#if CM_PROFILING_ENABLED
+
+inline void histogram::record(std::uint64_t p_value) const
+{
+    detail::histogramSlots & slots = detail::local().histograms[m_id];
+
+    const std::uint64_t count = slots.count.load(std::memory_order_relaxed);
+    if (count == 0 || p_value < slots.min.load(std::memory_order_relaxed))
+    {
+        slots.min.store(p_value, std::memory_order_relaxed);
+    }
+    if (p_value > slots.max.load(std::memory_order_relaxed))
+    {
+        slots.max.store(p_value, std::memory_order_relaxed);
+    }
+    slots.count.store(count + 1, std::memory_order_relaxed);
+    detail::bump(slots.sum, p_value);
+
+    size_t bucket = p_value ? 64 - static_cast<size_t>(__builtin_clzll(p_value)) : 0;
+    detail::bump(slots.buckets[bucket], 1);
+}
+
+inline traceRegion::~traceRegion()
+{
+    detail::threadData & data = detail::local();
+    if (!data.trace)
+    {
+        data.trace = std::make_unique<detail::traceEvent[]>(traceCapacity);
+    }
+    data.trace[data.traced++ % traceCapacity] = {m_name, m_start, steadyClock::now()};
+}
+
+#endif // CM_PROFILING_ENABLED
+
+} // namespace prof
+} // namespace cm
+
 #endif // TOOLS_H
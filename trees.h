@@ -10,12 +10,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <common/numeric.h>
+#include <common/tools.h>
 
 // TODO: * be careful: number of *: 1-based, level etc.: 0-based
 //       * interface
@@ -23,19 +28,158 @@
 namespace cm
 {
 
+//! \brief A contiguous span of a tree level, as handed to the induction kernels.
+//! \a current points to the first node of the span on \a level, \a next to its leftmost child on the level below.
+//! In a recombinantBTree current[i] springs from next[i] & next[i + 1], in a recombinantTTree from next[i] ... next[i + 2].
+template <typename Node>
+struct levelSpan
+{
+    //! \brief The level of the \a current nodes.
+    size_t level;
+    //! \brief The position of the first node of the span within its level.
+    size_t offset;
+    //! \brief The number of nodes in the span on \a level.
+    size_t size;
+    Node * current;
+    const Node * next;
+};
+
+//! @name Tree geometries
+//! Stateless index arithmetic of the tree shapes, resolved at compile time.
+//! The polymorphic trees below are implemented in terms of these; staticTree & the fixed trees use them directly.
+//! The recombinant geometries are constexpr throughout; the level of an index is found via the square root of the
+//! \p Root policy, \see detail::floatRoot & detail::integerRoot.
+///@{
+
+namespace detail
+{
+//! \brief floor(sqrt(n)), estimated in floating point & corrected by the geometries.
+//! Via isqrt in constant expressions, which requires std::is_constant_evaluated (C++20); use integerRoot before that.
+struct floatRoot
+{
+    static constexpr size_t estimate(size_t n);
+};
+
+//! \brief floor(sqrt(n)) in integer arithmetic only, \see isqrt.
+struct integerRoot
+{
+    static constexpr size_t estimate(size_t n);
+};
+} // namespace detail
+
+//! \brief The geometry of a complete binary tree in BFS indexing.
+struct binaryGeometry
+{
+    //! \brief Number of elements up to and including(!) the given level.
+    static size_t numElems(size_t level);
+
+    static size_t goUp(size_t ind);
+    static size_t goDownLeft(size_t ind);
+    static size_t goDownRight(size_t ind);
+};
+
+//! \brief The geometry of a binary tree where the inner nodes spring from two parents.
+template <typename Root = detail::floatRoot>
+struct basicRecombinantBGeometry
+{
+    //! \brief Get the level from the index.
+    //! \param ind - The array index.
+    static constexpr size_t level(size_t ind);
+    //! \brief level_size
+    //! \param ind - The array index.
+    static constexpr size_t level_size(size_t ind);
+    //! \brief left_boundary - inclusive!
+    static constexpr size_t left_boundary(size_t level);
+    //! \brief right_boundary - inclusive.
+    static constexpr size_t right_boundary(size_t level);
+    //! \brief Number of elements up to and including(!) the given level.
+    static constexpr size_t numElems(size_t level);
+
+    // alias for compatibility - goUpLeft
+    static constexpr size_t goUp(size_t ind);
+    static constexpr size_t goUpLeft(size_t ind);
+    static constexpr size_t goUpRight(size_t ind);
+    static constexpr size_t goDownLeft(size_t ind);
+    static constexpr size_t goDownRight(size_t ind);
+};
+using recombinantBGeometry = basicRecombinantBGeometry<>;
+
+//! \brief The geometry of a tree where the inner nodes spring from three parents.
+template <typename Root = detail::floatRoot>
+struct basicRecombinantTGeometry
+{
+    //! \brief Get the level from the index.
+    //! \param ind - The array index.
+    static constexpr size_t level(size_t ind);
+    //! \brief level_size
+    //! \param ind - The array index.
+    static constexpr size_t level_size(size_t ind);
+    //! \brief left_boundary - inclusive!
+    static constexpr size_t left_boundary(size_t level);
+    //! \brief right_boundary - inclusive.
+    static constexpr size_t right_boundary(size_t level);
+    //! \brief Number of elements up to and including(!) the given level.
+    static constexpr size_t numElems(size_t level);
+
+    // alias for compatibility - goUpLeft
+    static constexpr size_t goUp(size_t ind);
+    static constexpr size_t goUpLeft(size_t ind);
+    static constexpr size_t goUpCenter(size_t ind);
+    static constexpr size_t goUpRight(size_t ind);
+    static constexpr size_t goDownLeft(size_t ind);
+    static constexpr size_t goDownCenter(size_t ind);
+    static constexpr size_t goDownRight(size_t ind);
+};
+using recombinantTGeometry = basicRecombinantTGeometry<>;
+///@}
+
+//! \brief Per-level ranges of changed nodes, used for the incremental recomputation of the recombinant trees.
+//! Each level keeps the hull of its marked positions (relative to the left boundary).
+class dirtyRanges
+{
+public:
+    //! \brief dirtyRanges
+    //! \param numLevels - the number of levels of the tree
+    explicit dirtyRanges(size_t numLevels);
+
+    //! \brief Marks the position \p pos on \p level.
+    void mark(size_t level, size_t pos);
+    //! \brief Marks the positions [\p first, \p last] on \p level.
+    void mark(size_t level, size_t first, size_t last);
+    //! \brief Whether anything is marked at all.
+    bool any() const;
+    //! \brief Whether anything on \p level is marked.
+    bool marked(size_t level) const;
+    //! \brief The hull of the marked positions on \p level, inclusive. Only meaningful if marked(level).
+    std::pair<size_t, size_t> range(size_t level) const;
+    //! \brief The deepest level with a mark. Only meaningful if any().
+    size_t deepest() const;
+    //! \brief Unmarks everything.
+    void clear();
+
+private:
+    // empty ranges have first > last
+    std::vector<std::pair<size_t, size_t>> m_ranges;
+    size_t m_deepest{0};
+    bool m_any{false};
+};
+
 //! \brief An implementation of a fixed-depth binary tree.
 //! Requires \p Node to have a default value signifying an empty(leaf) node.
 //! BFS indexing, matching the underlying array container.
-template <typename Node>
+//! \tparam Alloc: the allocator of the underlying array, e.g. one of those in allocators.h.
+template <typename Node, typename Alloc = std::allocator<Node>>
 class bTree
 {
 public:
     using value_type = Node;
+    using allocator_type = Alloc;
 
     //! \brief bTree
     //! \param depth - number of sub-levels, [0, inf)
+    //! \param alloc - the allocator of the underlying array
     //! Root is level 0!
-    bTree(size_t depth);
+    bTree(size_t depth, const Alloc & alloc = Alloc());
     virtual ~bTree() = default;
 
     //! @name Index-based operations
@@ -88,6 +232,8 @@ public:
 
     //! @name Node-based operations
     //! These look up the node, so slower (\f$\mathcal{O}(n)\f$) than index-based operations.
+    //! The lookup returns the first node of equal value, so they are ambiguous for repeating values;
+    //! use nodeRef for navigation instead.
     ///@{
     // std::vector will naturally throw when out of bounds or parent of root, so no possibility of an invalid ref
     //! \brief root
@@ -116,30 +262,48 @@ public:
     // No harm in these getting inherited, worst-case scenario is overwriting of same nodes.
     std::vector<size_t> copySubTree(size_t indS, size_t indT);
 
+    //! \brief Copies whole sub-tree from source index to target index, level by level & without allocating.
+    //! The descendants of a node on each level form a contiguous index range, so every level is a single block copy,
+    //! with the navigation invoked only twice per level. For overlapping ranges, possible in the recombinant trees,
+    //! each level is copied as if through an intermediate buffer.
+    //! Warning: indices must be on the same level!
+    //! \param indS: source index
+    //! \param indT: target index
+    //! \param sink: a callable with the signature void (size_t first, size_t count), invoked after each level
+    //!  with the target range just copied, e.g. to record the target indices into a caller-provided buffer.
+    template <typename Sink>
+    void copySubTreeRanges(size_t indS, size_t indT, Sink && sink);
+    //! \brief Copies whole sub-tree from source index to target index, level by level & without allocating.
+    //! \param indS: source index
+    //! \param indT: target index
+    void copySubTreeRanges(size_t indS, size_t indT);
+
 protected:
     //! \brief Used by child classes
     //! \param depth
     //! \param num_elements
-    bTree(size_t depth, size_t num_elements);
+    //! \param alloc
+    bTree(size_t depth, size_t num_elements, const Alloc & alloc = Alloc());
 
     // In-place implementation, called by the above.
     // Only relevant from the 1st sub-level down.
     void copySubTree(size_t indS, size_t indT, std::vector<size_t> & target_indices);
 
     size_t m_depth;
-    std::vector<Node> m_data;
+    std::vector<Node, Alloc> m_data;
 };
 
 
 //! \brief A binary tree where the inner nodes spring from two parents.
-template <typename Node>
-class recombinantBTree : public bTree<Node>
+template <typename Node, typename Alloc = std::allocator<Node>>
+class recombinantBTree : public bTree<Node, Alloc>
 {
 public:
     //! \brief recombinantBTree
     //! \param depth - number of sub-levels, [0, inf)
+    //! \param alloc - the allocator of the underlying array
     //! Root is level 0!
-    recombinantBTree(size_t depth);
+    recombinantBTree(size_t depth, const Alloc & alloc = Alloc());
 
     //! @name Geometry
     ///@{
@@ -155,6 +319,10 @@ public:
     static size_t right_boundary(size_t level);
     ///@}
 
+    //! \brief The contiguous storage of \p level, starting at its left boundary.
+    Node * levelData(size_t level);
+    const Node * levelData(size_t level) const;
+
     // called from constructor, so not virtual.
     size_t numElems(size_t level) const;
 
@@ -167,7 +335,7 @@ public:
     virtual size_t goDownRight(size_t ind) const override;
 
     //! @name Additional node-based operations
-    //! These look up the node, so slower than index-based operations.
+    //! These look up the node, so slower than index-based operations; see nodeRef for the index-based equivalent.
     ///@{
 
     //! \brief By convention, left parent.
@@ -201,10 +369,52 @@ public:
     //! \return A vector of copied indices in order of copying
     std::vector<size_t> copySubTreeRight(size_t indS, size_t indT);
 
+    //! @name Backward induction
+    ///@{
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! The leaves (level \a m_depth) have to be populated beforehand, e.g. with the terminal payoff.
+    //! \p kernel is invoked once per level with the whole level as a levelSpan; it is called directly,
+    //! so it can get inlined & the loop over the span vectorized. Clears the changes tracked for incrementalInduction.
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    void backwardInduction(Kernel && kernel);
+
+    //! \brief Sweeps the tree from \p fromLevel up to and including the root.
+    //! Level \p fromLevel + 1 has to be populated beforehand.
+    //! \param fromLevel: the first level to be calculated, must be smaller than the depth
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    void backwardInduction(size_t fromLevel, Kernel && kernel);
+    ///@}
+
+    //! @name Incremental recomputation
+    //! After a full backwardInduction, changing a few nodes only requires recomputing their ancestor cone,
+    //! which widens by a node per level towards the root & is bounded by goUpLeft & goUpRight.
+    ///@{
+    //! \brief Insert \p node at \p ind & mark it as changed for incrementalInduction.
+    //! NOTE: writes through operator[] or via a reference to the base class are not tracked, use markDirty for those.
+    void insert(size_t ind, Node node);
+    //! \brief Marks the node at \p ind as changed.
+    void markDirty(size_t ind);
+    //! \brief Whether any nodes have changed since the last induction.
+    bool dirty() const;
+    //! \brief Forgets about the changes.
+    void clearDirty();
+    //! \brief Recomputes only the ancestor cone of the nodes changed since the last induction.
+    //! The changed nodes themselves are taken as given. A changed inner node gets recomputed nonetheless
+    //! if it lies within the cone of a deeper change.
+    //! \param kernel: a callable with the signature void (levelSpan<Node>), as for backwardInduction; it gets invoked
+    //!  with the partial spans of the cone, so it must use levelSpan::offset wherever the position within the level matters.
+    template <typename Kernel>
+    void incrementalInduction(Kernel && kernel);
+    ///@}
+
 protected:
-    using super = bTree<Node>;
+    using super = bTree<Node, Alloc>;
 
 private:
+    dirtyRanges m_dirty;
+
     // deprecated recursive implementations.
     std::unique_ptr<std::unordered_set<size_t>> copySubTreeLeft(size_t indS, size_t indT, std::vector<size_t> & target_indices,
                                                                 std::unique_ptr<std::unordered_set<size_t>> pSeen = nullptr);
@@ -215,14 +425,15 @@ private:
 
 //! \brief A binary tree where the inner nodes spring from three parents.
 //! Similar interface to recombinantBTree, but not a subclass of the latter.
-template <typename Node>
-class recombinantTTree : public bTree<Node>
+template <typename Node, typename Alloc = std::allocator<Node>>
+class recombinantTTree : public bTree<Node, Alloc>
 {
 public:
     //! \brief recombinantTTree
     //! \param depth - number of sub-levels, [0, inf)
+    //! \param alloc - the allocator of the underlying array
     //! Root is level 0!
-    recombinantTTree(size_t depth);
+    recombinantTTree(size_t depth, const Alloc & alloc = Alloc());
 
     //! @name Geometry
     ///@{
@@ -238,6 +449,10 @@ public:
     static size_t right_boundary(size_t level);
     ///@}
 
+    //! \brief The contiguous storage of \p level, starting at its left boundary.
+    Node * levelData(size_t level);
+    const Node * levelData(size_t level) const;
+
     // called from constructor, so not virtual.
     size_t numElems(size_t level) const;
 
@@ -252,7 +467,7 @@ public:
     virtual size_t goDownRight(size_t ind) const override;
 
     //! @name Additional node-based operations
-    //! These look up the node, so slower than index-based operations.
+    //! These look up the node, so slower than index-based operations; see nodeRef for the index-based equivalent.
     ///@{
 
     //! \brief By convention, left parent.
@@ -275,112 +490,323 @@ public:
 
     ///@}
 
-// NOTE: not needed at the moment, can use inherited recursive copySubTree.
-//    //! \brief copies whole sub-tree from source index to target index,
-//    //! keeping the values for the shared nodes from the initial left descend.
-//    //! Warning: indices must be on the same level.
-//    //! \param indS: source index
-//    //! \param indT: target index
-//    //! \return A vector of copied indices in order of copying
-//    std::vector<size_t> copySubTreeSource(size_t indS, size_t indT);
-
-//    //! \brief copies whole sub-tree from source index to target index,
-//    //! setting the values for the shared nodes from final right descend.
-//    //! This means a left target can serve as a source for a node to its right later on!
-//    //! Warning: indices must be on the same level.
-//    //! \param indS: source index
-//    //! \param indT: target index
-//    //! \return A vector of copied indices in order of copying
-//    std::vector<size_t> copySubTreeTarget(size_t indS, size_t indT);
+    //! \brief copies whole sub-tree from source index to target index,
+    //! keeping the values for the shared nodes from the source sub-tree,
+    //! i.e. only the target nodes outside of the source sub-tree get copied.
+    //! Warning: indices must be on the same level.
+    //! \param indS: source index
+    //! \param indT: target index
+    //! \return A vector of copied indices in order of copying
+    std::vector<size_t> copySubTreeSource(size_t indS, size_t indT);
+
+    //! \brief copies whole sub-tree from source index to target index,
+    //! setting the values for the shared nodes from the target's descend, as if copied through an intermediate buffer.
+    //! This means a left target can serve as a source for a node to its right later on!
+    //! Warning: indices must be on the same level.
+    //! \param indS: source index
+    //! \param indT: target index
+    //! \return A vector of copied indices, level by level
+    std::vector<size_t> copySubTreeTarget(size_t indS, size_t indT);
+
+    //! @name Backward induction
+    ///@{
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! The leaves (level \a m_depth) have to be populated beforehand, e.g. with the terminal payoff.
+    //! \p kernel is invoked once per level with the whole level as a levelSpan, where each node springs from
+    //! its three children next[i] ... next[i + 2]. Clears the changes tracked for incrementalInduction.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    void backwardInduction(Kernel && kernel);
+
+    //! \brief Sweeps the tree from \p fromLevel up to and including the root.
+    //! Level \p fromLevel + 1 has to be populated beforehand.
+    //! \param fromLevel: the first level to be calculated, must be smaller than the depth
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    void backwardInduction(size_t fromLevel, Kernel && kernel);
+    ///@}
+
+    //! @name Incremental recomputation
+    //! After a full backwardInduction, changing a few nodes only requires recomputing their ancestor cone,
+    //! which widens by two nodes per level towards the root & is bounded by goUpLeft & goUpRight.
+    ///@{
+    //! \brief Insert \p node at \p ind & mark it as changed for incrementalInduction.
+    //! NOTE: writes through operator[] or via a reference to the base class are not tracked, use markDirty for those.
+    void insert(size_t ind, Node node);
+    //! \brief Marks the node at \p ind as changed.
+    void markDirty(size_t ind);
+    //! \brief Whether any nodes have changed since the last induction.
+    bool dirty() const;
+    //! \brief Forgets about the changes.
+    void clearDirty();
+    //! \brief Recomputes only the ancestor cone of the nodes changed since the last induction.
+    //! The changed nodes themselves are taken as given. A changed inner node gets recomputed nonetheless
+    //! if it lies within the cone of a deeper change.
+    //! \param kernel: a callable with the signature void (levelSpan<Node>), as for backwardInduction; it gets invoked
+    //!  with the partial spans of the cone, so it must use levelSpan::offset wherever the position within the level matters.
+    template <typename Kernel>
+    void incrementalInduction(Kernel && kernel);
+    ///@}
 
 protected:
-    using super = bTree<Node>;
+    using super = bTree<Node, Alloc>;
+
+private:
+    dirtyRanges m_dirty;
 };
 
 
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//  IMPLEMENTATION
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \brief A fixed-depth tree whose navigation is resolved statically via the \p Geometry policy.
+//! The counterpart of the polymorphic hierarchy above, without any virtual calls: the go* functions and
+//! the level arithmetic are inherited from \p Geometry & get inlined at the call site.
+//! \tparam Geometry: one of binaryGeometry, recombinantBGeometry, recombinantTGeometry or a class of the same interface.
+template <typename Node, typename Geometry>
+class staticTree : public Geometry
+{
+public:
+    using value_type = Node;
+    using geometry = Geometry;
 
+    //! \brief staticTree
+    //! \param depth - number of sub-levels, [0, inf)
+    //! Root is level 0!
+    explicit staticTree(size_t depth);
 
-// bTree
+    //! \brief Insert \p node at \p ind.
+    void insert(size_t ind, Node node);
+    //! \brief Remove the node at \p ind.
+    void remove(size_t ind);
+    //! \brief The total number of elements in the tree.
+    size_t totalElems() const;
+    //! \brief The number of total levels - the depth of the tree + 1.
+    size_t numLevels() const;
 
-template <typename Node>
-bTree<Node>::bTree(size_t depth) : m_depth(depth), m_data(numElems(m_depth))
-{}
+    Node & operator[](size_t ind);
+    const Node & operator[](size_t ind) const;
 
-template <typename Node>
-bTree<Node>::bTree(size_t depth, size_t num_elements) : m_depth(depth), m_data(num_elements)
-{}
+    //! \brief The begin iterator of the underlying structure.
+    auto begin();
+    //! \brief The end iterator of the underlying structure.
+    auto end();
 
-template <typename Node>
-void bTree<Node>::insert(size_t ind, Node node)
-{
-    m_data[ind] = node;
-}
+    Node & root();
+    const Node & root() const;
+
+    //! \brief The contiguous storage of \p level, starting at its left boundary.
+    //! Only available for the geometries with contiguous levels.
+    Node * levelData(size_t level);
+    const Node * levelData(size_t level) const;
+
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! Only available for the geometries with contiguous levels, i.e. those providing the *_boundary functions.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    void backwardInduction(Kernel && kernel);
+
+private:
+    size_t m_depth;
+    std::vector<Node> m_data;
+};
 
+//! \brief Statically dispatched counterpart of recombinantBTree.
 template <typename Node>
-void bTree<Node>::remove(size_t ind)
-{
-    m_data[ind] = Node{};
-}
+using staticRecombinantBTree = staticTree<Node, recombinantBGeometry>;
 
+//! \brief Statically dispatched counterpart of recombinantTTree.
 template <typename Node>
-size_t bTree<Node>::totalElems() const
-{
-    return m_data.size();
-}
+using staticRecombinantTTree = staticTree<Node, recombinantTGeometry>;
+
 
+//! \brief A recombinant binary tree that keeps only two adjacent levels in memory.
+//! Meant for backward induction where the nodes of a level depend on the level below alone, e.g. European payoffs:
+//! the memory used is \f$\mathcal{O}(depth)\f$ instead of \f$\mathcal{O}(depth^2)\f$.
+//! The addressing is the same as in recombinantBTree, but only the indices on the two levels of the current window,
+//! windowLevel() & windowLevel() + 1, are valid. The levels alternate between the two buffers by parity,
+//! so moving the window by one level keeps the shared level intact.
 template <typename Node>
-Node & bTree<Node>::operator[](size_t ind)
+class rollingRecombinantBTree : public recombinantBGeometry
 {
-    return m_data[ind];
-}
+public:
+    using value_type = Node;
+    using geometry = recombinantBGeometry;
 
-template <typename Node>
-const Node & bTree<Node>::operator[](size_t ind) const
+    //! \brief rollingRecombinantBTree
+    //! \param depth - number of sub-levels, [0, inf)
+    //! Root is level 0! The window is initially located at the leaves.
+    explicit rollingRecombinantBTree(size_t depth);
+
+    //! \brief The number of total levels - the depth of the tree + 1.
+    size_t numLevels() const;
+    //! \brief The number of elements actually stored.
+    size_t totalElems() const;
+
+    //! \brief The upper level of the window.
+    size_t windowLevel() const;
+    //! \brief Moves the window so that \p level & \p level + 1 are addressable.
+    //! No data gets moved, the contents of a level not shared with the previous window are those last stored in its buffer.
+    void setWindow(size_t level);
+    //! \brief Whether the index provided lies within the current window.
+    bool resident(size_t ind) const;
+
+    //! \brief operator []
+    //! \param ind: An array index in the full tree, must lie within the current window.
+    Node & operator[](size_t ind);
+    const Node & operator[](size_t ind) const;
+
+    //! \brief The contiguous storage of \p level, which must lie within the current window.
+    Node * levelData(size_t level);
+    const Node * levelData(size_t level) const;
+
+    Node & root();
+    const Node & root() const;
+
+    //! \brief Sweeps the tree from the level above the leaves up to and including the root.
+    //! The leaves have to be populated beforehand; the window travels up with the sweep and ends at the root.
+    //! \see recombinantBTree::backwardInduction
+    //! \param kernel: a callable with the signature void (levelSpan<Node>)
+    template <typename Kernel>
+    void backwardInduction(Kernel && kernel);
+
+private:
+    size_t m_depth;
+    size_t m_window;
+    // even & odd levels
+    std::vector<Node> m_levels[2];
+};
+
+
+//! @name Index-based navigation
+///@{
+
+//! \brief A lightweight handle on a tree node that carries its index.
+//! Navigation is index arithmetic via the tree's go* functions, so \f$\mathcal{O}(1)\f$ and unambiguous in contrast
+//! to the node-based operations of the trees. Works with any of the trees above; the directions not supported
+//! by the tree's geometry simply fail to compile. A const \p Tree yields read-only access.
+template <typename Tree>
+class nodeRef
 {
-    return m_data[ind];
-}
+public:
+    //! \brief nodeRef
+    //! \param tree
+    //! \param ind - The array index.
+    nodeRef(Tree & tree, size_t ind);
+
+    //! \brief The array index of the node.
+    size_t index() const;
+    //! \brief The level of the node.
+    size_t level() const;
+
+    //! \brief Access to the node value.
+    decltype(auto) operator*() const;
+    auto operator->() const;
+    //! \brief Access to the node value.
+    decltype(auto) value() const;
+
+    //! \brief Alias for compatibility - by convention, the left parent in recombinant trees.
+    nodeRef up() const;
+    nodeRef up_left() const;
+    nodeRef up_center() const;
+    nodeRef up_right() const;
+    nodeRef down_left() const;
+    nodeRef down_center() const;
+    nodeRef down_right() const;
+
+    bool operator==(const nodeRef & other) const;
+    bool operator!=(const nodeRef & other) const;
 
-template <typename Node>
-auto bTree<Node>::begin()
+private:
+    Tree * m_tree;
+    size_t m_ind;
+};
+
+//! \brief Iterates through a contiguous index range of a tree, yielding nodeRef.
+template <typename Tree>
+class nodeIterator
 {
-    return m_data.begin();
-}
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = nodeRef<Tree>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = nodeRef<Tree>;
 
-template <typename Node>
-auto bTree<Node>::end()
+    nodeIterator(Tree & tree, size_t ind);
+
+    nodeRef<Tree> operator*() const;
+    nodeIterator & operator++();
+    nodeIterator operator++(int);
+
+    bool operator==(const nodeIterator & other) const;
+    bool operator!=(const nodeIterator & other) const;
+
+private:
+    Tree * m_tree;
+    size_t m_ind;
+};
+
+//! \brief A range of nodes, e.g. a whole level, usable in range-for.
+template <typename Tree>
+class nodeRange
 {
-    return m_data.end();
-}
+public:
+    //! \brief nodeRange
+    //! \param tree
+    //! \param first - The first array index.
+    //! \param last - The last array index, inclusive!
+    nodeRange(Tree & tree, size_t first, size_t last);
 
-template <typename Node>
-size_t bTree<Node>::node2Ind(const Node & node) const
+    nodeIterator<Tree> begin() const;
+    nodeIterator<Tree> end() const;
+    size_t size() const;
+
+private:
+    Tree * m_tree;
+    size_t m_first;
+    size_t m_end;
+};
+
+//! \brief The handle on the node at \p ind.
+template <typename Tree>
+nodeRef<Tree> nodeAt(Tree & tree, size_t ind);
+
+//! \brief The nodes on \p level, from the left to the right boundary.
+//! Requires the trees with contiguous levels, i.e. recombinant ones.
+template <typename Tree>
+nodeRange<Tree> levelNodes(Tree & tree, size_t level);
+///@}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  IMPLEMENTATION
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+// Geometries
+
+constexpr size_t detail::floatRoot::estimate(size_t n)
 {
-    typename decltype(m_data)::const_iterator el;
-    if ((el = std::find(m_data.begin(), m_data.end(), node)) != m_data.end())
+#ifdef __cpp_lib_is_constant_evaluated
+    if (std::is_constant_evaluated())
     {
-        return std::distance(m_data.begin(), el);
+        return isqrt(n);
     }
-
-    throw std::range_error("Node not in tree");
+#endif
+    return static_cast<size_t>(std::sqrt(static_cast<double>(n)));
 }
 
-template <typename Node>
-size_t bTree<Node>::numElems(size_t level) const
+constexpr size_t detail::integerRoot::estimate(size_t n)
 {
-    return static_cast<size_t>(std::pow(2, level + 1) - 1);
+    return isqrt(n);
 }
 
-template <typename Node>
-size_t bTree<Node>::numLevels() const
+inline size_t binaryGeometry::numElems(size_t level)
 {
-    return m_depth + 1;
+    return static_cast<size_t>(std::pow(2, level + 1) - 1);
 }
 
-template <typename Node>
-size_t bTree<Node>::goUp(size_t ind) const
+inline size_t binaryGeometry::goUp(size_t ind)
 {
     if (ind == 0)
     {
@@ -390,83 +816,456 @@ size_t bTree<Node>::goUp(size_t ind) const
     return (ind - 1) / 2;
 }
 
-template <typename Node>
-size_t bTree<Node>::goDownLeft(size_t ind) const
+inline size_t binaryGeometry::goDownLeft(size_t ind)
 {
     return 2 * ind + 1;
 }
 
-template <typename Node>
-size_t bTree<Node>::goDownRight(size_t ind) const
+inline size_t binaryGeometry::goDownRight(size_t ind)
 {
     return 2 * ind + 2;
 }
 
-template <typename Node>
-Node & bTree<Node>::root()
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::level(size_t ind)
 {
-    return const_cast<Node &>(const_cast<const bTree<Node> *>(this)->root());
+    // analytic solution, a floating-point estimate of the root gets corrected to remain exact for large indices
+    size_t l = (Root::estimate(8 * ind + 1) - 1) / 2;
+    while (l > 0 && left_boundary(l) > ind)
+    {
+        --l;
+    }
+    while (left_boundary(l + 1) <= ind)
+    {
+        ++l;
+    }
+    return l;
 }
 
-template <typename Node>
-const Node & bTree<Node>::root() const
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::level_size(size_t ind)
 {
-    return m_data[0];
+    return level(ind) + 1;
 }
 
-template <typename Node>
-Node & bTree<Node>::parent(const Node & node)
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::left_boundary(size_t level)
+{
+    // arithmetic sum, in integers to stay exact
+    return level * (level + 1) / 2;
+}
 
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::right_boundary(size_t level)
 {
-    return const_cast<Node &>(const_cast<const bTree<Node> *>(this)->parent(node));
+    return left_boundary(level + 1) - 1;
 }
 
-template <typename Node>
-const Node & bTree<Node>::parent(const Node & node) const
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::numElems(size_t level)
 {
-    return m_data[goUp(node2Ind(node))];
+    // arithmetic sum w 0-based indexing
+    return left_boundary(level + 1);
 }
 
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::goUp(size_t ind)
+{
+    return goUpLeft(ind);
+}
 
-template <typename Node>
-Node & bTree<Node>::leftchild(const Node & node)
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::goUpLeft(size_t ind)
 {
-    return const_cast<Node &>(const_cast<const bTree<Node> *>(this)->leftchild(node));
+    // left boundary nodes have no left parent
+    if (ind == left_boundary(level(ind)))
+    {
+        throw std::range_error("The node corresponding to the index provided is on the left boundary!");
+    }
+    return ind - level_size(ind);
 }
 
-template <typename Node>
-const Node & bTree<Node>::leftchild(const Node & node) const
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::goUpRight(size_t ind)
 {
-    return m_data[goDownLeft(node2Ind(node))];
+    // right boundary nodes have no right parent
+    // the next ind is the left boundary node of the next level
+    if (ind == right_boundary(level(ind)))
+    {
+        throw std::range_error("The node corresponding to the index provided is on the right boundary!");
+    }
+    return ind - level_size(ind) + 1;
 }
 
-template <typename Node>
-Node & bTree<Node>::rightchild(const Node & node)
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::goDownLeft(size_t ind)
 {
-    return const_cast<Node &>(const_cast<const bTree<Node> *>(this)->rightchild(node));
+    return ind + level_size(ind);
 }
 
-template <typename Node>
-const Node & bTree<Node>::rightchild(const Node & node) const
+template <typename Root>
+constexpr size_t basicRecombinantBGeometry<Root>::goDownRight(size_t ind)
 {
-    return m_data[goDownRight(node2Ind(node))];
+    return ind + level_size(ind) + 1;
 }
 
-template <typename Node>
-std::vector<size_t> bTree<Node>::copySubTree(size_t indS, size_t indT)
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::level(size_t ind)
 {
-    std::vector<size_t> ret{};
-    copySubTree(indS, indT, ret);
-    return ret;
+    // analytic derivation, a floating-point estimate of the root gets corrected to remain exact for large indices
+    size_t l = Root::estimate(ind);
+    while (l > 0 && left_boundary(l) > ind)
+    {
+        --l;
+    }
+    while (left_boundary(l + 1) <= ind)
+    {
+        ++l;
+    }
+    return l;
 }
 
-template <typename Node>
-void bTree<Node>::copySubTree(size_t indS, size_t indT, std::vector<size_t> & target_indices)
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::level_size(size_t ind)
 {
-    m_data[indT] = m_data[indS];
-    target_indices.push_back(indT);
+    return 1 + 2 * level(ind);
+}
 
-    // left-first depth-first
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::left_boundary(size_t level)
+{
+    return level * level;
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::right_boundary(size_t level)
+{
+    return (level + 1) * (level + 1) - 1;
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::numElems(size_t level)
+{
+    return (1 + level) * (1 + level);
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goUp(size_t ind)
+{
+    return goUpLeft(ind);
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goUpLeft(size_t ind)
+{
+    // first 2 cannot go up left
+    if (ind == left_boundary(level(ind)) || (ind == left_boundary(level(ind)) + 1))
+    {
+        throw std::range_error("The node corresponding to the index provided is on the left boundary!");
+    }
+
+    return ind - level_size(ind);
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goUpCenter(size_t ind)
+{
+    // first & last cannot go up straight
+    if (ind == left_boundary(level(ind)) || ind == right_boundary(level(ind)))
+    {
+        throw std::range_error("The node corresponding to the index provided is on the boundary & cannot go up!");
+    }
+    return ind - level_size(ind) + 1;
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goUpRight(size_t ind)
+{
+    // last 2 cannot go up right
+    if (ind == right_boundary(level(ind)) || (ind == right_boundary(level(ind)) - 1))
+    {
+        throw std::range_error("The node corresponding to the index provided is on the right boundary!");
+    }
+    return ind - level_size(ind) + 2;
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goDownLeft(size_t ind)
+{
+    return ind + level_size(ind);
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goDownCenter(size_t ind)
+{
+    return ind + level_size(ind) + 1;
+}
+
+template <typename Root>
+constexpr size_t basicRecombinantTGeometry<Root>::goDownRight(size_t ind)
+{
+    return ind + level_size(ind) + 2;
+}
+
+
+// dirtyRanges
+
+inline dirtyRanges::dirtyRanges(size_t numLevels) : m_ranges(numLevels, {1, 0})
+{}
+
+inline void dirtyRanges::mark(size_t level, size_t pos)
+{
+    mark(level, pos, pos);
+}
+
+inline void dirtyRanges::mark(size_t level, size_t first, size_t last)
+{
+    auto & range = m_ranges[level];
+    if (range.first > range.second)
+    {
+        range = {first, last};
+    }
+    else
+    {
+        range = {std::min(range.first, first), std::max(range.second, last)};
+    }
+
+    m_deepest = m_any ? std::max(m_deepest, level) : level;
+    m_any = true;
+}
+
+inline bool dirtyRanges::any() const
+{
+    return m_any;
+}
+
+inline bool dirtyRanges::marked(size_t level) const
+{
+    return m_ranges[level].first <= m_ranges[level].second;
+}
+
+inline std::pair<size_t, size_t> dirtyRanges::range(size_t level) const
+{
+    return m_ranges[level];
+}
+
+inline size_t dirtyRanges::deepest() const
+{
+    return m_deepest;
+}
+
+inline void dirtyRanges::clear()
+{
+    if (!m_any)
+    {
+        return;
+    }
+
+    // nothing is marked below the deepest level
+    std::fill(m_ranges.begin(), m_ranges.begin() + m_deepest + 1, std::pair<size_t, size_t>{1, 0});
+    m_deepest = 0;
+    m_any = false;
+}
+
+
+// bTree
+
+template <typename Node, typename Alloc>
+bTree<Node, Alloc>::bTree(size_t depth, const Alloc & alloc) : m_depth(depth), m_data(numElems(m_depth), alloc)
+{}
+
+template <typename Node, typename Alloc>
+bTree<Node, Alloc>::bTree(size_t depth, size_t num_elements, const Alloc & alloc)
+    : m_depth(depth)
+    , m_data(num_elements, alloc)
+{}
+
+template <typename Node, typename Alloc>
+void bTree<Node, Alloc>::insert(size_t ind, Node node)
+{
+    m_data[ind] = node;
+}
+
+template <typename Node, typename Alloc>
+void bTree<Node, Alloc>::remove(size_t ind)
+{
+    m_data[ind] = Node{};
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::totalElems() const
+{
+    return m_data.size();
+}
+
+template <typename Node, typename Alloc>
+Node & bTree<Node, Alloc>::operator[](size_t ind)
+{
+    return m_data[ind];
+}
+
+template <typename Node, typename Alloc>
+const Node & bTree<Node, Alloc>::operator[](size_t ind) const
+{
+    return m_data[ind];
+}
+
+template <typename Node, typename Alloc>
+auto bTree<Node, Alloc>::begin()
+{
+    return m_data.begin();
+}
+
+template <typename Node, typename Alloc>
+auto bTree<Node, Alloc>::end()
+{
+    return m_data.end();
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::node2Ind(const Node & node) const
+{
+    typename decltype(m_data)::const_iterator el;
+    if ((el = std::find(m_data.begin(), m_data.end(), node)) != m_data.end())
+    {
+        return std::distance(m_data.begin(), el);
+    }
+
+    throw std::range_error("Node not in tree");
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::numElems(size_t level) const
+{
+    return binaryGeometry::numElems(level);
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::numLevels() const
+{
+    return m_depth + 1;
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::goUp(size_t ind) const
+{
+    return binaryGeometry::goUp(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::goDownLeft(size_t ind) const
+{
+    return binaryGeometry::goDownLeft(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t bTree<Node, Alloc>::goDownRight(size_t ind) const
+{
+    return binaryGeometry::goDownRight(ind);
+}
+
+template <typename Node, typename Alloc>
+Node & bTree<Node, Alloc>::root()
+{
+    return const_cast<Node &>(const_cast<const bTree<Node, Alloc> *>(this)->root());
+}
+
+template <typename Node, typename Alloc>
+const Node & bTree<Node, Alloc>::root() const
+{
+    return m_data[0];
+}
+
+template <typename Node, typename Alloc>
+Node & bTree<Node, Alloc>::parent(const Node & node)
+
+{
+    return const_cast<Node &>(const_cast<const bTree<Node, Alloc> *>(this)->parent(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & bTree<Node, Alloc>::parent(const Node & node) const
+{
+    return m_data[goUp(node2Ind(node))];
+}
+
+
+template <typename Node, typename Alloc>
+Node & bTree<Node, Alloc>::leftchild(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const bTree<Node, Alloc> *>(this)->leftchild(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & bTree<Node, Alloc>::leftchild(const Node & node) const
+{
+    return m_data[goDownLeft(node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+Node & bTree<Node, Alloc>::rightchild(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const bTree<Node, Alloc> *>(this)->rightchild(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & bTree<Node, Alloc>::rightchild(const Node & node) const
+{
+    return m_data[goDownRight(node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+std::vector<size_t> bTree<Node, Alloc>::copySubTree(size_t indS, size_t indT)
+{
+    std::vector<size_t> ret{};
+    copySubTree(indS, indT, ret);
+    return ret;
+}
+
+template <typename Node, typename Alloc>
+template <typename Sink>
+void bTree<Node, Alloc>::copySubTreeRanges(size_t indS, size_t indT, Sink && sink)
+{
+    // the descendants on a level are bounded by the leftmost & the rightmost descend
+    size_t sourceFirst = indS;
+    size_t sourceLast = indS;
+    size_t target = indT;
+
+    while (sourceLast < m_data.size() && target + (sourceLast - sourceFirst) < m_data.size())
+    {
+        size_t count = sourceLast - sourceFirst + 1;
+        auto first = m_data.begin() + sourceFirst;
+
+        if (target > sourceFirst)
+        {
+            std::copy_backward(first, first + count, m_data.begin() + target + count);
+        }
+        else
+        {
+            std::copy(first, first + count, m_data.begin() + target);
+        }
+        sink(target, count);
+
+        // proceed to the next level
+        sourceFirst = goDownLeft(sourceFirst);
+        sourceLast = goDownRight(sourceLast);
+        target = goDownLeft(target);
+    }
+}
+
+template <typename Node, typename Alloc>
+void bTree<Node, Alloc>::copySubTreeRanges(size_t indS, size_t indT)
+{
+    copySubTreeRanges(indS, indT, [](size_t, size_t) {});
+}
+
+template <typename Node, typename Alloc>
+void bTree<Node, Alloc>::copySubTree(size_t indS, size_t indT, std::vector<size_t> & target_indices)
+{
+    m_data[indT] = m_data[indS];
+    target_indices.push_back(indT);
+
+    // left-first depth-first
     size_t sourceLeft = goDownLeft(indS);
     size_t targetLeft = goDownLeft(indT);
 
@@ -493,431 +1292,1021 @@ void bTree<Node>::copySubTree(size_t indS, size_t indT, std::vector<size_t> & ta
 // recombinantBTree
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-template <typename Node>
-recombinantBTree<Node>::recombinantBTree(size_t depth) : bTree<Node>(depth, numElems(depth))
+template <typename Node, typename Alloc>
+recombinantBTree<Node, Alloc>::recombinantBTree(size_t depth, const Alloc & alloc)
+    : bTree<Node, Alloc>(depth, numElems(depth), alloc)
+    , m_dirty(depth + 1)
 {}
 
-template <typename Node>
-size_t recombinantBTree<Node>::level(size_t ind)
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::level(size_t ind)
+{
+    return recombinantBGeometry::level(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::level_size(size_t ind)
+{
+    return recombinantBGeometry::level_size(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::left_boundary(size_t level)
+{
+    return recombinantBGeometry::left_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::right_boundary(size_t level)
+{
+    return recombinantBGeometry::right_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+Node * recombinantBTree<Node, Alloc>::levelData(size_t level)
+{
+    return super::m_data.data() + left_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+const Node * recombinantBTree<Node, Alloc>::levelData(size_t level) const
+{
+    return super::m_data.data() + left_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::numElems(size_t level) const
+{
+    return recombinantBGeometry::numElems(level);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::goUp(size_t ind) const
+{
+    return recombinantBGeometry::goUp(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::goUpLeft(size_t ind) const
+{
+    return recombinantBGeometry::goUpLeft(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::goUpRight(size_t ind) const
+{
+    return recombinantBGeometry::goUpRight(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::goDownLeft(size_t ind) const
+{
+    return recombinantBGeometry::goDownLeft(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantBTree<Node, Alloc>::goDownRight(size_t ind) const
+{
+    return recombinantBGeometry::goDownRight(ind);
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantBTree<Node, Alloc>::parent(const Node & node) const
+{
+    return parentLeft(node);
+}
+
+template <typename Node, typename Alloc>
+Node & recombinantBTree<Node, Alloc>::parentLeft(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const recombinantBTree<Node, Alloc> *>(this)->parentLeft(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantBTree<Node, Alloc>::parentLeft(const Node & node) const
+{
+    return super::m_data[goUpLeft(super::node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+Node & recombinantBTree<Node, Alloc>::parentRight(const Node & node)
 {
-    // analytic solution
-    return static_cast<size_t>(std::round(std::sqrt(1 + 2 * ind) - 1));
+    return const_cast<Node &>(const_cast<const recombinantBTree<Node, Alloc> *>(this)->parentRight(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantBTree<Node, Alloc>::parentRight(const Node & node) const
+{
+    return super::m_data[goUpRight(super::node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+std::vector<size_t> recombinantBTree<Node, Alloc>::copySubTreeLeft(size_t indS, size_t indT)
+{
+    std::vector<size_t> ret{};
+
+    if (!(level(indS) == level(indT)))
+    {
+        throw std::range_error("Source and target nodes must be on the same level!");
+    }
+
+    // non-recursive implementation:
+    // this is equal to setting the last value on the level to the value preceding it for all the levels below
+    // and including the initial
+    size_t l = level(indS);
+    size_t last = right_boundary(l);
+
+    while (last < super::m_data.size())
+    {
+        super::m_data[last] = super::m_data[last - 1];
+
+        // proceed to the next level
+        ++l;
+        last = right_boundary(l);
+    }
+
+    return ret;
+}
+
+template <typename Node, typename Alloc>
+std::vector<size_t> recombinantBTree<Node, Alloc>::copySubTreeRight(size_t indS, size_t indT)
+{
+    std::vector<size_t> ret{};
+
+    if (!(level(indS) == level(indT)))
+    {
+        throw std::range_error("Source and target nodes must be on the same level!");
+    }
+
+    // non-recursive implementation
+    // this is equal to setting the whole level to the left value below source for all the levels
+    // below and including the initial
+    size_t l = level(indS);
+    size_t offset = indS - left_boundary(l);
+    size_t source = indS;
+
+    while (source < super::m_data.size())
+    {
+        auto start = super::m_data.begin() + source + 1;
+        // fill to the end of the level - std::algorithms use a half-open bracket
+        auto end = super::m_data.begin() + left_boundary(l + 1);
+
+        std::fill(start, end, super::m_data[source]);
+
+        // proceed to the next level
+        ++l;
+        source = left_boundary(l) + offset;
+    }
+
+    return ret;
+}
+
+template <typename Node, typename Alloc>
+template <typename Kernel>
+void recombinantBTree<Node, Alloc>::backwardInduction(Kernel && kernel)
+{
+    if (super::m_depth > 0)
+    {
+        backwardInduction(super::m_depth - 1, std::forward<Kernel>(kernel));
+    }
+
+    // everything is up to date
+    m_dirty.clear();
+}
+
+template <typename Node, typename Alloc>
+template <typename Kernel>
+void recombinantBTree<Node, Alloc>::backwardInduction(size_t fromLevel, Kernel && kernel)
+{
+    if (fromLevel >= super::m_depth)
+    {
+        throw std::range_error("The starting level must lie above the leaves!");
+    }
+    CM_PROFILE_SCOPE("recombinantBTree::backwardInduction");
+
+    // levels are contiguous in the array, the level below begins right after the current one ends
+    for (size_t l = fromLevel + 1; l-- > 0;)
+    {
+        Node * current = super::m_data.data() + left_boundary(l);
+        kernel(levelSpan<Node>{l, 0, l + 1, current, current + l + 1});
+    }
+}
+
+template <typename Node, typename Alloc>
+void recombinantBTree<Node, Alloc>::insert(size_t ind, Node node)
+{
+    super::insert(ind, std::move(node));
+    markDirty(ind);
+}
+
+template <typename Node, typename Alloc>
+void recombinantBTree<Node, Alloc>::markDirty(size_t ind)
+{
+    size_t l = level(ind);
+    m_dirty.mark(l, ind - left_boundary(l));
+}
+
+template <typename Node, typename Alloc>
+bool recombinantBTree<Node, Alloc>::dirty() const
+{
+    return m_dirty.any();
+}
+
+template <typename Node, typename Alloc>
+void recombinantBTree<Node, Alloc>::clearDirty()
+{
+    m_dirty.clear();
+}
+
+template <typename Node, typename Alloc>
+template <typename Kernel>
+void recombinantBTree<Node, Alloc>::incrementalInduction(Kernel && kernel)
+{
+    if (!m_dirty.any())
+    {
+        return;
+    }
+
+    // the changed positions on the current level, starting with the deepest change
+    size_t l = m_dirty.deepest();
+    auto [first, last] = m_dirty.range(l);
+
+    while (l-- > 0)
+    {
+        // the parents of the changed nodes below
+        first = first == 0 ? 0 : first - 1;
+        last = std::min(last, l);
+
+        Node * current = levelData(l);
+        kernel(levelSpan<Node>{l, first, last - first + 1, current + first, current + l + 1 + first});
+
+        // the changes on this level propagate further up as well
+        if (m_dirty.marked(l))
+        {
+            auto range = m_dirty.range(l);
+            first = std::min(first, range.first);
+            last = std::max(last, range.second);
+        }
+    }
+
+    m_dirty.clear();
+}
+
+template <typename Node, typename Alloc>
+std::unique_ptr<std::unordered_set<size_t>>
+recombinantBTree<Node, Alloc>::copySubTreeLeft(size_t indS, size_t indT, std::vector<size_t> & target_indices,
+                                        std::unique_ptr<std::unordered_set<size_t>> pSeen)
+{
+    // top level
+    if (!pSeen)
+    {
+        pSeen = std::make_unique<std::unordered_set<size_t>>();
+    }
+
+    bTree<Node, Alloc>::m_data[indT] = super::m_data[indS];
+    target_indices.push_back(indT);
+    // shared nodes are always sources
+    pSeen->insert(indS);
+
+    // left-first depth-first
+    size_t sourceLeft = goDownLeft(indS);
+    size_t targetLeft = goDownLeft(indT);
+
+    // go left
+    // only go left if not visited before, else keep the value of the initial first descend
+    if (sourceLeft < super::m_data.size() && sourceLeft > 0 && targetLeft < super::m_data.size() && targetLeft > 0 &&
+        pSeen->find(targetLeft) == pSeen->end())
+    {
+        pSeen = copySubTreeLeft(sourceLeft, targetLeft, target_indices, std::move(pSeen));
+
+        // go right
+        size_t sourceRight = goDownRight(indS);
+        size_t targetRight = goDownRight(indT);
+
+        if (sourceRight < super::m_data.size() && sourceRight > 0 && targetRight < super::m_data.size() && targetRight > 0)
+        {
+            pSeen = copySubTreeLeft(sourceRight, targetRight, target_indices, std::move(pSeen));
+        }
+    }
+
+    // return - goes up a level
+    return pSeen;
+}
+
+template <typename Node, typename Alloc>
+void recombinantBTree<Node, Alloc>::copySubTreeRight(size_t indS, size_t indT, std::vector<size_t> & target_indices)
+{
+    bTree<Node, Alloc>::m_data[indT] = super::m_data[indS];
+    target_indices.push_back(indT);
+
+    // left-first depth-first
+    size_t sourceLeft = goDownLeft(indS);
+    size_t targetLeft = goDownLeft(indT);
+
+    // always go left
+    if (sourceLeft < super::m_data.size() && sourceLeft > 0 && targetLeft < super::m_data.size() && targetLeft > 0)
+    {
+        copySubTreeRight(sourceLeft, targetLeft, target_indices);
+
+        // go right
+        size_t sourceRight = goDownRight(indS);
+        size_t targetRight = goDownRight(indT);
+
+        if (sourceRight < super::m_data.size() && sourceRight > 0 && targetRight < super::m_data.size() && targetRight > 0)
+        {
+            copySubTreeRight(sourceRight, targetRight, target_indices);
+        }
+    }
+
+    // return - goes up a level
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// recombinantTTree
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename Node, typename Alloc>
+recombinantTTree<Node, Alloc>::recombinantTTree(size_t depth, const Alloc & alloc)
+    : bTree<Node, Alloc>(depth, numElems(depth), alloc)
+    , m_dirty(depth + 1)
+{}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::level(size_t ind)
+{
+    return recombinantTGeometry::level(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::level_size(size_t ind)
+{
+    return recombinantTGeometry::level_size(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::left_boundary(size_t level)
+{
+    return recombinantTGeometry::left_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::right_boundary(size_t level)
+{
+    return recombinantTGeometry::right_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+Node * recombinantTTree<Node, Alloc>::levelData(size_t level)
+{
+    return super::m_data.data() + left_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+const Node * recombinantTTree<Node, Alloc>::levelData(size_t level) const
+{
+    return super::m_data.data() + left_boundary(level);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::numElems(size_t level) const
+{
+    return recombinantTGeometry::numElems(level);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goUp(size_t ind) const
+{
+    return recombinantTGeometry::goUp(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goUpLeft(size_t ind) const
+{
+    return recombinantTGeometry::goUpLeft(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goUpCenter(size_t ind) const
+{
+    return recombinantTGeometry::goUpCenter(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goUpRight(size_t ind) const
+{
+    return recombinantTGeometry::goUpRight(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goDownLeft(size_t ind) const
+{
+    return recombinantTGeometry::goDownLeft(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goDownCenter(size_t ind) const
+{
+    return recombinantTGeometry::goDownCenter(ind);
+}
+
+template <typename Node, typename Alloc>
+size_t recombinantTTree<Node, Alloc>::goDownRight(size_t ind) const
+{
+    return recombinantTGeometry::goDownRight(ind);
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantTTree<Node, Alloc>::parent(const Node & node) const
+{
+    return parentLeft(node);
+}
+
+template <typename Node, typename Alloc>
+Node & recombinantTTree<Node, Alloc>::parentLeft(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const recombinantTTree<Node, Alloc> *>(this)->parentLeft(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantTTree<Node, Alloc>::parentLeft(const Node & node) const
+{
+    return super::m_data[goUpLeft(super::node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+Node & recombinantTTree<Node, Alloc>::parentCenter(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const recombinantTTree<Node, Alloc> *>(this)->parentCenter(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantTTree<Node, Alloc>::parentCenter(const Node & node) const
+{
+    return super::m_data[goUpCenter(super::node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+Node & recombinantTTree<Node, Alloc>::parentRight(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const recombinantTTree<Node, Alloc> *>(this)->parentRight(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantTTree<Node, Alloc>::parentRight(const Node & node) const
+{
+    return super::m_data[goUpRight(super::node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+Node & recombinantTTree<Node, Alloc>::centerchild(const Node & node)
+{
+    return const_cast<Node &>(const_cast<const recombinantTTree<Node, Alloc> *>(this)->centerchild(node));
+}
+
+template <typename Node, typename Alloc>
+const Node & recombinantTTree<Node, Alloc>::centerchild(const Node & node) const
+{
+    return super::m_data[goDownCenter(super::node2Ind(node))];
+}
+
+template <typename Node, typename Alloc>
+std::vector<size_t> recombinantTTree<Node, Alloc>::copySubTreeSource(size_t indS, size_t indT)
+{
+    std::vector<size_t> ret{};
+
+    if (!(level(indS) == level(indT)))
+    {
+        throw std::range_error("Source and target nodes must be on the same level!");
+    }
+
+    // non-recursive implementation:
+    // on the k-th level below, the sub-trees span the positions [o, o + 2k] from the position o of their roots.
+    // The target nodes within the source's span are shared & kept, the rest are copied from the same relative position.
+    // The copies are read from the source's span & only written outside of it, so no source node is ever overwritten
+    // before being read, whatever the order.
+    size_t l = level(indS);
+    size_t posS = indS - left_boundary(l);
+    size_t posT = indT - left_boundary(l);
+
+    if (posS == posT)
+    {
+        return ret;
+    }
+
+    for (size_t k = 0; l + k <= super::m_depth; ++k)
+    {
+        size_t base = left_boundary(l + k);
+        size_t first = posT;
+        size_t last = posT + 2 * k;
+
+        if (posT > posS)
+        {
+            first = std::max(first, posS + 2 * k + 1);
+        }
+        else
+        {
+            last = std::min(last, posS - 1);
+        }
+
+        for (size_t pos = first; pos <= last; ++pos)
+        {
+            super::m_data[base + pos] = super::m_data[base + pos - posT + posS];
+            ret.push_back(base + pos);
+        }
+    }
+
+    return ret;
+}
+
+template <typename Node, typename Alloc>
+std::vector<size_t> recombinantTTree<Node, Alloc>::copySubTreeTarget(size_t indS, size_t indT)
+{
+    std::vector<size_t> ret{};
+
+    if (!(level(indS) == level(indT)))
+    {
+        throw std::range_error("Source and target nodes must be on the same level!");
+    }
+
+    // non-recursive implementation:
+    // the whole sub-tree is a contiguous range on every level, copied with overlaps resolved in favour of the target
+    ret.reserve(numElems(super::m_depth - level(indS)));
+    super::copySubTreeRanges(indS, indT, [&ret](size_t first, size_t count) {
+        for (size_t ind = first; ind < first + count; ++ind)
+        {
+            ret.push_back(ind);
+        }
+    });
+
+    return ret;
+}
+
+template <typename Node, typename Alloc>
+template <typename Kernel>
+void recombinantTTree<Node, Alloc>::backwardInduction(Kernel && kernel)
+{
+    if (super::m_depth > 0)
+    {
+        backwardInduction(super::m_depth - 1, std::forward<Kernel>(kernel));
+    }
+
+    // everything is up to date
+    m_dirty.clear();
+}
+
+template <typename Node, typename Alloc>
+template <typename Kernel>
+void recombinantTTree<Node, Alloc>::backwardInduction(size_t fromLevel, Kernel && kernel)
+{
+    if (fromLevel >= super::m_depth)
+    {
+        throw std::range_error("The starting level must lie above the leaves!");
+    }
+    CM_PROFILE_SCOPE("recombinantTTree::backwardInduction");
+
+    // levels are contiguous in the array, the level below begins right after the current one ends
+    for (size_t l = fromLevel + 1; l-- > 0;)
+    {
+        Node * current = super::m_data.data() + left_boundary(l);
+        kernel(levelSpan<Node>{l, 0, 2 * l + 1, current, current + 2 * l + 1});
+    }
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::level_size(size_t ind)
-{
-    return level(ind) + 1;
-}
 
-template <typename Node>
-size_t recombinantBTree<Node>::left_boundary(size_t level)
+template <typename Node, typename Alloc>
+void recombinantTTree<Node, Alloc>::insert(size_t ind, Node node)
 {
-    return arithm_sum(level, 1ul, 1ul);
+    super::insert(ind, std::move(node));
+    markDirty(ind);
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::right_boundary(size_t level)
+template <typename Node, typename Alloc>
+void recombinantTTree<Node, Alloc>::markDirty(size_t ind)
 {
-    return arithm_sum(level + 1, 1ul, 1ul) - 1;
+    size_t l = level(ind);
+    m_dirty.mark(l, ind - left_boundary(l));
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::numElems(size_t level) const
+template <typename Node, typename Alloc>
+bool recombinantTTree<Node, Alloc>::dirty() const
 {
-    // arithmetic sum w 0-based indexing
-    return arithm_sum(level + 1, 1ul, 1ul);
+    return m_dirty.any();
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::goUp(size_t ind) const
+template <typename Node, typename Alloc>
+void recombinantTTree<Node, Alloc>::clearDirty()
 {
-    return goUpLeft(ind);
+    m_dirty.clear();
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::goUpLeft(size_t ind) const
+template <typename Node, typename Alloc>
+template <typename Kernel>
+void recombinantTTree<Node, Alloc>::incrementalInduction(Kernel && kernel)
 {
-
-    // left boundary nodes have no left parent
-    if (ind == left_boundary(level(ind)))
+    if (!m_dirty.any())
     {
-        throw std::range_error("The node corresponding to the index provided is on the left boundary!");
+        return;
     }
-    return ind - level_size(ind);
-}
 
-template <typename Node>
-size_t recombinantBTree<Node>::goUpRight(size_t ind) const
-{
-    // right boundary nodes have no right parent
-    // the next ind is the left boundary node of the next level
-    if (ind == right_boundary(level(ind)))
+    // the changed positions on the current level, starting with the deepest change
+    size_t l = m_dirty.deepest();
+    auto [first, last] = m_dirty.range(l);
+
+    while (l-- > 0)
     {
-        throw std::range_error("The node corresponding to the index provided is on the right boundary!");
+        // the parents of the changed nodes below
+        first = first < 2 ? 0 : first - 2;
+        last = std::min(last, 2 * l);
+
+        Node * current = levelData(l);
+        kernel(levelSpan<Node>{l, first, last - first + 1, current + first, current + 2 * l + 1 + first});
+
+        // the changes on this level propagate further up as well
+        if (m_dirty.marked(l))
+        {
+            auto range = m_dirty.range(l);
+            first = std::min(first, range.first);
+            last = std::max(last, range.second);
+        }
     }
-    return ind - level_size(ind) + 1;
+
+    m_dirty.clear();
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::goDownLeft(size_t ind) const
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// staticTree
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename Node, typename Geometry>
+staticTree<Node, Geometry>::staticTree(size_t depth) : m_depth(depth), m_data(Geometry::numElems(depth))
+{}
+
+template <typename Node, typename Geometry>
+void staticTree<Node, Geometry>::insert(size_t ind, Node node)
 {
-    return ind + level_size(ind);
+    m_data[ind] = std::move(node);
 }
 
-template <typename Node>
-size_t recombinantBTree<Node>::goDownRight(size_t ind) const
+template <typename Node, typename Geometry>
+void staticTree<Node, Geometry>::remove(size_t ind)
 {
-    return ind + level_size(ind) + 1;
+    m_data[ind] = Node{};
 }
 
-template <typename Node>
-const Node & recombinantBTree<Node>::parent(const Node & node) const
+template <typename Node, typename Geometry>
+size_t staticTree<Node, Geometry>::totalElems() const
 {
-    return parentLeft(node);
+    return m_data.size();
 }
 
-template <typename Node>
-Node & recombinantBTree<Node>::parentLeft(const Node & node)
+template <typename Node, typename Geometry>
+size_t staticTree<Node, Geometry>::numLevels() const
 {
-    return const_cast<Node &>(const_cast<const recombinantBTree<Node> *>(this)->parentLeft(node));
+    return m_depth + 1;
 }
 
-template <typename Node>
-const Node & recombinantBTree<Node>::parentLeft(const Node & node) const
+template <typename Node, typename Geometry>
+Node & staticTree<Node, Geometry>::operator[](size_t ind)
 {
-    return super::m_data[goUpLeft(super::node2Ind(node))];
+    return m_data[ind];
 }
 
-template <typename Node>
-Node & recombinantBTree<Node>::parentRight(const Node & node)
+template <typename Node, typename Geometry>
+const Node & staticTree<Node, Geometry>::operator[](size_t ind) const
 {
-    return const_cast<Node &>(const_cast<const recombinantBTree<Node> *>(this)->parentRight(node));
+    return m_data[ind];
 }
 
-template <typename Node>
-const Node & recombinantBTree<Node>::parentRight(const Node & node) const
+template <typename Node, typename Geometry>
+auto staticTree<Node, Geometry>::begin()
 {
-    return super::m_data[goUpRight(super::node2Ind(node))];
+    return m_data.begin();
 }
 
-template <typename Node>
-std::vector<size_t> recombinantBTree<Node>::copySubTreeLeft(size_t indS, size_t indT)
+template <typename Node, typename Geometry>
+auto staticTree<Node, Geometry>::end()
 {
-    std::vector<size_t> ret{};
-
-    if (!(level(indS) == level(indT)))
-    {
-        throw std::range_error("Source and target nodes must be on the same level!");
-    }
+    return m_data.end();
+}
 
-    // non-recursive implementation:
-    // this is equal to setting the last value on the level to the value preceding it for all the levels below
-    // and including the initial
-    size_t l = level(indS);
-    size_t last = right_boundary(l);
+template <typename Node, typename Geometry>
+Node & staticTree<Node, Geometry>::root()
+{
+    return m_data[0];
+}
 
-    while (last < super::m_data.size())
-    {
-        super::m_data[last] = super::m_data[last - 1];
+template <typename Node, typename Geometry>
+const Node & staticTree<Node, Geometry>::root() const
+{
+    return m_data[0];
+}
 
-        // proceed to the next level
-        ++l;
-        last = right_boundary(l);
-    }
+template <typename Node, typename Geometry>
+Node * staticTree<Node, Geometry>::levelData(size_t level)
+{
+    return m_data.data() + Geometry::left_boundary(level);
+}
 
-    return ret;
+template <typename Node, typename Geometry>
+const Node * staticTree<Node, Geometry>::levelData(size_t level) const
+{
+    return m_data.data() + Geometry::left_boundary(level);
 }
 
-template <typename Node>
-std::vector<size_t> recombinantBTree<Node>::copySubTreeRight(size_t indS, size_t indT)
+template <typename Node, typename Geometry>
+template <typename Kernel>
+void staticTree<Node, Geometry>::backwardInduction(Kernel && kernel)
 {
-    std::vector<size_t> ret{};
+    CM_PROFILE_SCOPE("staticTree::backwardInduction");
 
-    if (!(level(indS) == level(indT)))
+    for (size_t l = m_depth; l-- > 0;)
     {
-        throw std::range_error("Source and target nodes must be on the same level!");
+        Node * current = m_data.data() + Geometry::left_boundary(l);
+        const Node * next = m_data.data() + Geometry::left_boundary(l + 1);
+        kernel(levelSpan<Node>{l, 0, static_cast<size_t>(next - current), current, next});
     }
+}
 
-    // non-recursive implementation
-    // this is equal to setting the whole level to the left value below source for all the levels
-    // below and including the initial
-    size_t l = level(indS);
-    size_t offset = indS - left_boundary(l);
-    size_t source = indS;
 
-    while (source < super::m_data.size())
-    {
-        auto start = super::m_data.begin() + source + 1;
-        // fill to the end of the level - std::algorithms use a half-open bracket
-        auto end = super::m_data.begin() + left_boundary(l + 1);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Index-based navigation
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        std::fill(start, end, super::m_data[source]);
 
-        // proceed to the next level
-        ++l;
-        source = left_boundary(l) + offset;
-    }
+template <typename Tree>
+nodeRef<Tree>::nodeRef(Tree & tree, size_t ind) : m_tree(&tree), m_ind(ind)
+{}
 
-    return ret;
+template <typename Tree>
+size_t nodeRef<Tree>::index() const
+{
+    return m_ind;
 }
 
-template <typename Node>
-std::unique_ptr<std::unordered_set<size_t>>
-recombinantBTree<Node>::copySubTreeLeft(size_t indS, size_t indT, std::vector<size_t> & target_indices,
-                                        std::unique_ptr<std::unordered_set<size_t>> pSeen)
+template <typename Tree>
+size_t nodeRef<Tree>::level() const
 {
-    // top level
-    if (!pSeen)
-    {
-        pSeen = std::make_unique<std::unordered_set<size_t>>();
-    }
-
-    bTree<Node>::m_data[indT] = super::m_data[indS];
-    target_indices.push_back(indT);
-    // shared nodes are always sources
-    pSeen->insert(indS);
-
-    // left-first depth-first
-    size_t sourceLeft = goDownLeft(indS);
-    size_t targetLeft = goDownLeft(indT);
+    return m_tree->level(m_ind);
+}
 
-    // go left
-    // only go left if not visited before, else keep the value of the initial first descend
-    if (sourceLeft < super::m_data.size() && sourceLeft > 0 && targetLeft < super::m_data.size() && targetLeft > 0 &&
-        pSeen->find(targetLeft) == pSeen->end())
-    {
-        pSeen = copySubTreeLeft(sourceLeft, targetLeft, target_indices, std::move(pSeen));
+template <typename Tree>
+decltype(auto) nodeRef<Tree>::operator*() const
+{
+    return (*m_tree)[m_ind];
+}
 
-        // go right
-        size_t sourceRight = goDownRight(indS);
-        size_t targetRight = goDownRight(indT);
+template <typename Tree>
+auto nodeRef<Tree>::operator->() const
+{
+    return &(*m_tree)[m_ind];
+}
 
-        if (sourceRight < super::m_data.size() && sourceRight > 0 && targetRight < super::m_data.size() && targetRight > 0)
-        {
-            pSeen = copySubTreeLeft(sourceRight, targetRight, target_indices, std::move(pSeen));
-        }
-    }
+template <typename Tree>
+decltype(auto) nodeRef<Tree>::value() const
+{
+    return (*m_tree)[m_ind];
+}
 
-    // return - goes up a level
-    return pSeen;
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::up() const
+{
+    return {*m_tree, m_tree->goUp(m_ind)};
 }
 
-template <typename Node>
-void recombinantBTree<Node>::copySubTreeRight(size_t indS, size_t indT, std::vector<size_t> & target_indices)
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::up_left() const
 {
-    bTree<Node>::m_data[indT] = super::m_data[indS];
-    target_indices.push_back(indT);
+    return {*m_tree, m_tree->goUpLeft(m_ind)};
+}
 
-    // left-first depth-first
-    size_t sourceLeft = goDownLeft(indS);
-    size_t targetLeft = goDownLeft(indT);
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::up_center() const
+{
+    return {*m_tree, m_tree->goUpCenter(m_ind)};
+}
 
-    // always go left
-    if (sourceLeft < super::m_data.size() && sourceLeft > 0 && targetLeft < super::m_data.size() && targetLeft > 0)
-    {
-        copySubTreeRight(sourceLeft, targetLeft, target_indices);
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::up_right() const
+{
+    return {*m_tree, m_tree->goUpRight(m_ind)};
+}
 
-        // go right
-        size_t sourceRight = goDownRight(indS);
-        size_t targetRight = goDownRight(indT);
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::down_left() const
+{
+    return {*m_tree, m_tree->goDownLeft(m_ind)};
+}
 
-        if (sourceRight < super::m_data.size() && sourceRight > 0 && targetRight < super::m_data.size() && targetRight > 0)
-        {
-            copySubTreeRight(sourceRight, targetRight, target_indices);
-        }
-    }
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::down_center() const
+{
+    return {*m_tree, m_tree->goDownCenter(m_ind)};
+}
 
-    // return - goes up a level
+template <typename Tree>
+nodeRef<Tree> nodeRef<Tree>::down_right() const
+{
+    return {*m_tree, m_tree->goDownRight(m_ind)};
 }
 
+template <typename Tree>
+bool nodeRef<Tree>::operator==(const nodeRef & other) const
+{
+    return m_tree == other.m_tree && m_ind == other.m_ind;
+}
 
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// recombinantTTree
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Tree>
+bool nodeRef<Tree>::operator!=(const nodeRef & other) const
+{
+    return !(*this == other);
+}
 
 
-template <typename Node>
-recombinantTTree<Node>::recombinantTTree(size_t depth) : bTree<Node>(depth, numElems(depth))
+template <typename Tree>
+nodeIterator<Tree>::nodeIterator(Tree & tree, size_t ind) : m_tree(&tree), m_ind(ind)
 {}
 
-template <typename Node>
-size_t recombinantTTree<Node>::level(size_t ind)
+template <typename Tree>
+nodeRef<Tree> nodeIterator<Tree>::operator*() const
 {
-    // analytic derivation
-    return static_cast<size_t>(std::floor(std::sqrt(ind)));
+    return {*m_tree, m_ind};
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::level_size(size_t ind)
+template <typename Tree>
+nodeIterator<Tree> & nodeIterator<Tree>::operator++()
 {
-    return 1 + 2 * level(ind);
+    ++m_ind;
+    return *this;
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::left_boundary(size_t level)
+template <typename Tree>
+nodeIterator<Tree> nodeIterator<Tree>::operator++(int)
 {
-    return level * level;
+    nodeIterator ret = *this;
+    ++m_ind;
+    return ret;
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::right_boundary(size_t level)
+template <typename Tree>
+bool nodeIterator<Tree>::operator==(const nodeIterator & other) const
 {
-    return (level + 1) * (level + 1) - 1;
+    return m_ind == other.m_ind && m_tree == other.m_tree;
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::numElems(size_t level) const
+template <typename Tree>
+bool nodeIterator<Tree>::operator!=(const nodeIterator & other) const
 {
-    return (1 + level) * (1 + level);
+    return !(*this == other);
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::goUp(size_t ind) const
+
+template <typename Tree>
+nodeRange<Tree>::nodeRange(Tree & tree, size_t first, size_t last) : m_tree(&tree), m_first(first), m_end(last + 1)
+{}
+
+template <typename Tree>
+nodeIterator<Tree> nodeRange<Tree>::begin() const
 {
-    return goUpLeft(ind);
+    return {*m_tree, m_first};
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::goUpLeft(size_t ind) const
+template <typename Tree>
+nodeIterator<Tree> nodeRange<Tree>::end() const
 {
-    // first 2 cannot go up left
-    if (ind == left_boundary(level(ind)) || (ind == left_boundary(level(ind)) + 1))
-    {
-        throw std::range_error("The node corresponding to the index provided is on the left boundary!");
-    }
-
-    return ind - level_size(ind);
+    return {*m_tree, m_end};
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::goUpCenter(size_t ind) const
+template <typename Tree>
+size_t nodeRange<Tree>::size() const
 {
-    // first & last cannot go up straight
-    if (ind == left_boundary(level(ind)) || ind == right_boundary(level(ind)))
-    {
-        throw std::range_error("The node corresponding to the index provided is on the boundary & cannot go up!");
-    }
-    return ind - level_size(ind) + 1;
+    return m_end - m_first;
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::goUpRight(size_t ind) const
+
+template <typename Tree>
+nodeRef<Tree> nodeAt(Tree & tree, size_t ind)
 {
-    // last 2 cannot go up right
-    if (ind == right_boundary(level(ind)) || (ind == right_boundary(level(ind)) - 1))
-    {
-        throw std::range_error("The node corresponding to the index provided is on the right boundary!");
-    }
-    return ind - level_size(ind) + 2;
+    return {tree, ind};
 }
 
-template <typename Node>
-size_t recombinantTTree<Node>::goDownLeft(size_t ind) const
+template <typename Tree>
+nodeRange<Tree> levelNodes(Tree & tree, size_t level)
 {
-    return ind + level_size(ind);
+    return {tree, tree.left_boundary(level), tree.right_boundary(level)};
 }
 
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// rollingRecombinantBTree
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
 template <typename Node>
-size_t recombinantTTree<Node>::goDownCenter(size_t ind) const
+rollingRecombinantBTree<Node>::rollingRecombinantBTree(size_t depth)
+    : m_depth(depth)
+    , m_window(depth == 0 ? 0 : depth - 1)
+    , m_levels{std::vector<Node>(depth + 1), std::vector<Node>(depth + 1)}
+{}
+
+template <typename Node>
+size_t rollingRecombinantBTree<Node>::numLevels() const
 {
-    return ind + level_size(ind) + 1;
+    return m_depth + 1;
 }
 
 template <typename Node>
-size_t recombinantTTree<Node>::goDownRight(size_t ind) const
+size_t rollingRecombinantBTree<Node>::totalElems() const
 {
-    return ind + level_size(ind) + 2;
+    return m_levels[0].size() + m_levels[1].size();
 }
 
 template <typename Node>
-const Node & recombinantTTree<Node>::parent(const Node & node) const
+size_t rollingRecombinantBTree<Node>::windowLevel() const
 {
-    return parentLeft(node);
+    return m_window;
 }
 
 template <typename Node>
-Node & recombinantTTree<Node>::parentLeft(const Node & node)
+void rollingRecombinantBTree<Node>::setWindow(size_t level)
 {
-    return const_cast<Node &>(const_cast<const recombinantTTree<Node> *>(this)->parentLeft(node));
+    if (level > m_depth)
+    {
+        throw std::range_error("The window must lie within the tree!");
+    }
+    m_window = level;
 }
 
 template <typename Node>
-const Node & recombinantTTree<Node>::parentLeft(const Node & node) const
+bool rollingRecombinantBTree<Node>::resident(size_t ind) const
 {
-    return super::m_data[goUpLeft(super::node2Ind(node))];
+    size_t l = level(ind);
+    return (l == m_window || l == m_window + 1) && l <= m_depth;
 }
 
 template <typename Node>
-Node & recombinantTTree<Node>::parentCenter(const Node & node)
+Node & rollingRecombinantBTree<Node>::operator[](size_t ind)
 {
-    return const_cast<Node &>(const_cast<const recombinantTTree<Node> *>(this)->parentCenter(node));
+    return const_cast<Node &>(const_cast<const rollingRecombinantBTree<Node> *>(this)->operator[](ind));
 }
 
 template <typename Node>
-const Node & recombinantTTree<Node>::parentCenter(const Node & node) const
+const Node & rollingRecombinantBTree<Node>::operator[](size_t ind) const
 {
-    super::m_data[goUpCenter(super::node2Ind(node))];
+#ifdef TESTING
+    if (!resident(ind))
+    {
+        throw std::range_error("The index provided lies outside of the current window!");
+    }
+#endif
+    size_t l = level(ind);
+    return m_levels[l & 1][ind - left_boundary(l)];
 }
 
 template <typename Node>
-Node & recombinantTTree<Node>::parentRight(const Node & node)
+Node * rollingRecombinantBTree<Node>::levelData(size_t level)
 {
-    return const_cast<Node &>(const_cast<const recombinantTTree<Node> *>(this)->parentRight(node));
+    return const_cast<Node *>(const_cast<const rollingRecombinantBTree<Node> *>(this)->levelData(level));
 }
 
 template <typename Node>
-const Node & recombinantTTree<Node>::parentRight(const Node & node) const
+const Node * rollingRecombinantBTree<Node>::levelData(size_t level) const
 {
-    super::m_data[goUpRight(super::node2Ind(node))];
+#ifdef TESTING
+    if (level != m_window && level != m_window + 1)
+    {
+        throw std::range_error("The level provided lies outside of the current window!");
+    }
+#endif
+    return m_levels[level & 1].data();
 }
 
 template <typename Node>
-Node & recombinantTTree<Node>::centerchild(const Node & node)
+Node & rollingRecombinantBTree<Node>::root()
 {
-    return const_cast<Node &>(const_cast<const recombinantTTree<Node> *>(this)->centerchild(node));
+    return m_levels[0][0];
 }
 
 template <typename Node>
-const Node & recombinantTTree<Node>::centerchild(const Node & node) const
+const Node & rollingRecombinantBTree<Node>::root() const
 {
-    super::m_data[goDownCenter(super::node2Ind(node))];
+    return m_levels[0][0];
 }
 
-//template<typename Node>
-//std::vector<size_t> recombinantTTree<Node>::copySubTreeSource(size_t indS, size_t indT)
-//{
-//    std::vector<size_t> ret{};
-
-//    if (!(level(indS) == level(indT)))
-//    {
-//        throw std::range_error("Source and target nodes must be on the same level!");
-//    }
-
-//    // TODO: see notes
-
-////    // non-recursive implementation:
-////    // this is equal to setting the last value on the level to the value preceding it for all the levels below
-////    // and including the initial
-////    size_t l = level(indS);
-////    size_t last = right_boundary(l);
-
-////    while (last < super::m_data.size())
-////    {
-////        super::m_data[last] = super::m_data[last - 1];
-
-////        // proceed to the next level
-////        ++l;
-////        last = right_boundary(l);
-////    }
+template <typename Node>
+template <typename Kernel>
+void rollingRecombinantBTree<Node>::backwardInduction(Kernel && kernel)
+{
+    CM_PROFILE_SCOPE("rollingRecombinantBTree::backwardInduction");
 
-//    return ret;
-//}
-//template<typename Node>
-//std::vector<size_t> recombinantTTree<Node>::copySubTreeTarget(size_t indS, size_t indT)
-//{
-//    // TODO: see notes
-//}
+    for (size_t l = m_depth; l-- > 0;)
+    {
+        m_window = l;
+        kernel(levelSpan<Node>{l, 0, l + 1, m_levels[l & 1].data(), m_levels[(l + 1) & 1].data()});
+    }
+}
 
 } // namespace cm
 